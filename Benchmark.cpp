@@ -0,0 +1,418 @@
+#include "Benchmark.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+#include "ChessBoard.h"
+#include "ChessMove.h"
+#include "ChessPiece.h"
+#include "Engine.h"
+#include "Evaluation.h"
+#include "Nnue.h"
+#include "PawnTable.h"
+
+using std::chrono::steady_clock;
+
+// openings and middlegames of varied character, also used as match starts
+static const char *benchPositions[] = {
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+    "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+    "rnbqkb1r/pp1p1ppp/4pn2/2p5/2PP4/2N5/PP2PPPP/R1BQKBNR w KQkq - 0 4",
+    "r1bqkbnr/pppp1ppp/2n5/4p3/4P3/5N2/PPPP1PPP/RNBQKB1R w KQkq - 2 3",
+    "rnbqkbnr/pp2pppp/3p4/2p5/4P3/5N2/PPPP1PPP/RNBQKB1R w KQkq - 0 3",
+    "r1bq1rk1/ppp1bppp/2n2n2/3pp3/2PP4/2N1PN2/PP2BPPP/R1BQK2R w KQ - 0 7",
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+};
+const int BENCH_POSITIONS =
+    sizeof(benchPositions) / sizeof(benchPositions[0]);
+
+static int millisecondsSince(steady_clock::time_point start) {
+    return int(std::chrono::duration_cast<std::chrono::milliseconds>(
+                   steady_clock::now() - start)
+                   .count());
+}
+
+int benchSearch(int depth, const std::vector<int> &threads,
+                std::ostream &os) {
+    SearchLimits limits;
+    limits.depth = depth;
+
+    int baseline = 0, total = 0;
+    for (int count : threads) {
+        Engine engine;
+        engine.setThreads(count);
+
+        uint64_t nodes = 0;
+        int pawnHits = 0, firstMove = 0;
+        const steady_clock::time_point start = steady_clock::now();
+        for (const char *fen : benchPositions) {
+            ChessBoard board;
+            board.setFen(fen);
+            engine.clearHash();
+            engine.search(board, limits);
+            nodes += engine.nodes();
+            pawnHits += engine.pawnHits();
+            firstMove += engine.firstMoveCutoffs();
+        }
+        const int ms = std::max(1, millisecondsSince(start));
+        if (!baseline) baseline = ms;
+        total += ms;
+
+        os << "threads " << std::setw(2) << count << ": depth " << depth
+           << " in " << ms << " ms, " << nodes << " nodes, "
+           << nodes * 1000 / ms << " nps, speedup " << std::fixed
+           << std::setprecision(2) << double(baseline) / ms
+           << ", pawn hits " << std::setprecision(1)
+           << pawnHits / 10.0 / BENCH_POSITIONS << "%, first move cutoffs "
+           << firstMove / 10.0 / BENCH_POSITIONS << '%' << std::endl;
+    }
+    return total;
+}
+
+// plain alpha-beta, everything, then everything but one feature at a time
+static const struct {
+    const char *name;
+    const char *disabled;
+} selectiveConfigs[] = {
+    {"plain", "all"},          {"selective", ""},
+    {"no qsearch", "qsearch"}, {"no null move", "null"},
+    {"no lmr", "lmr"},         {"no futility", "futility"},
+    {"no razoring", "razoring"}, {"no extensions", "extensions"},
+};
+
+int benchSelective(int depth, std::ostream &os) {
+    SearchLimits limits;
+    limits.depth = depth;
+
+    int total = 0;
+    for (const auto &config : selectiveConfigs) {
+        SearchOptions options;
+        if (*config.disabled) disableFeatures(options, config.disabled);
+        Engine engine;
+        engine.setOptions(options);
+
+        // the branching factor is averaged geometrically over positions
+        uint64_t nodes = 0;
+        double logBranching = 0;
+        int measured = 0;
+        const steady_clock::time_point start = steady_clock::now();
+        for (const char *fen : benchPositions) {
+            ChessBoard board;
+            board.setFen(fen);
+            engine.clearHash();
+            engine.search(board, limits);
+            nodes += engine.nodes();
+            if (engine.branchingFactor() > 0) {
+                logBranching += std::log(engine.branchingFactor());
+                measured++;
+            }
+        }
+        const int ms = std::max(1, millisecondsSince(start));
+        total += ms;
+
+        os << std::left << std::setw(14) << config.name << std::right
+           << ": depth " << depth << " in " << std::setw(6) << ms << " ms, "
+           << std::setw(10) << nodes << " nodes, ebf " << std::fixed
+           << std::setprecision(2)
+           << (measured ? std::exp(logBranching / measured) : 0.0)
+           << std::endl;
+    }
+    return total;
+}
+
+// the sum keeps the calls from being optimised away
+static double timeEval(const ChessBoard boards[], int positions,
+                       int iterations, long long &sum,
+                       PawnTable *pawns = NULL) {
+    sum = 0;
+    const steady_clock::time_point start = steady_clock::now();
+    for (int n = 0; n < iterations; n++)
+        for (int i = 0; i < positions; i++) sum += evaluate(boards[i], pawns);
+    const double ns =
+        std::chrono::duration<double, std::nano>(steady_clock::now() - start)
+            .count();
+    return ns / (double(iterations) * positions);
+}
+
+void benchEval(int iterations, std::ostream &os) {
+    const int positions = BENCH_POSITIONS;
+    ChessBoard boards[positions];
+    for (int i = 0; i < positions; i++) {
+        boards[i].setFen(benchPositions[i]);
+        os << std::setw(6) << evaluate(boards[i]) << "  " << benchPositions[i]
+           << '\n';
+    }
+
+    long long sum;
+    double ns = timeEval(boards, positions, iterations, sum);
+    os << std::fixed << std::setprecision(1) << "evaluations "
+       << (long long)iterations * positions << ", " << ns
+       << " ns each (checksum " << sum << ")" << std::endl;
+
+    // the same positions over and over, so this is the all-hits cost
+    PawnTable pawns;
+    ns = timeEval(boards, positions, iterations, sum, &pawns);
+    os << "with pawn table: " << ns << " ns each (checksum " << sum
+       << ")" << std::endl;
+    if (!nnueEnabled()) return;
+
+    // every kernel must produce the same scores, only faster or slower
+    const std::string selected = nnueKernel();
+    long long reference = 0;
+    bool agree = true;
+    for (int k = 0; k < nnueKernelCount(); k++) {
+        selectNnueKernel(nnueKernelName(k));
+        for (ChessBoard &board : boards) board.refreshAccumulator();
+        ns = timeEval(boards, positions, iterations, sum);
+        if (k == 0) reference = sum;
+        agree = agree && sum == reference;
+        os << "nnue " << std::setw(6) << nnueKernelName(k) << ": " << ns
+           << " ns each (checksum " << sum << ")" << std::endl;
+    }
+    selectNnueKernel(selected.c_str());
+    os << (agree ? "kernels agree" : "kernels disagree") << std::endl;
+}
+
+// static exchange results with P 100, N and B 325, R 500, Q 1000; the
+// first entries are from a widely used SEE test suite
+static const struct {
+    const char *fen;
+    const char *move;
+    int value;
+} seeSuite[] = {
+    {"1k1r4/1pp4p/p7/4p3/8/P5P1/1PP4P/2K1R3 w - - 0 1", "e1e5", 100},
+    {"1k1r3q/1ppn3p/p4b2/4p3/8/P2N2P1/1PP1R1BP/2K1Q3 w - - 0 1", "d3e5",
+     -225},
+    {"4R3/2r3p1/5bk1/1p1r3p/p2PR1P1/P1BK1P2/1P6/8 b - - 0 1", "h5g4", 0},
+    {"4R3/2r3p1/5bk1/1p1r1p1p/p2PR1P1/P1BK1P2/1P6/8 b - - 0 1", "h5g4", 0},
+    {"2r1r1k1/pp1bppbp/3p1np1/q3P3/2P2P2/1P2B3/P1N1B1PP/2RQ1RK1 b - - 0 1",
+     "d6e5", 100},
+    // rooks stacked behind each other on a file
+    {"3r2k1/3r4/8/8/3p4/8/3R4/3R2K1 w - - 0 1", "d2d4", -400},
+    // a bishop behind a recapturing pawn joins in
+    {"4k3/8/5b2/4p3/3p4/8/3R4/3R2K1 w - - 0 1", "d2d4", -400},
+    {"4k3/8/2p5/3p4/8/4N3/8/4K3 w - - 0 1", "e3d5", -225},
+    {"4k3/8/4p3/3n4/8/1B6/8/4K3 w - - 0 1", "b3d5", 0},
+    {"4k3/8/8/3q4/4P3/8/8/4K3 w - - 0 1", "e4d5", 1000},
+    // quiet moves onto attacked squares
+    {"4k3/8/3p4/8/4N3/8/8/4K3 w - - 0 1", "e4c5", -325},
+    {"4k3/8/3p4/8/4N3/8/8/4K3 w - - 0 1", "e4f6", 0},
+    // promotions are not exchanged out
+    {"4k3/P7/8/8/8/8/8/4K3 w - - 0 1", "a7a8q", 0},
+};
+
+static ChessMove parseMove(const ChessBoard &board, const char *text) {
+    MoveList moves;
+    board.generateMoves(moves);
+    char buf[6];
+    for (ChessMove move : moves)
+        if (!strcmp(text, move.str(buf))) return move;
+    return ChessMove();
+}
+
+int benchSee(int iterations, std::ostream &os) {
+    // the exact value is the largest threshold the move still meets
+    int failures = 0;
+    for (const auto &test : seeSuite) {
+        ChessBoard board;
+        board.setFen(test.fen);
+        const ChessMove move = parseMove(board, test.move);
+        const bool ok = !move.isNull() && board.see(move, test.value) &&
+                        !board.see(move, test.value + 1);
+        if (!ok) {
+            failures++;
+            os << "FAIL " << test.move << " expected " << test.value << "  "
+               << test.fen << '\n';
+        }
+    }
+    os << sizeof(seeSuite) / sizeof(seeSuite[0]) - failures << " of "
+       << sizeof(seeSuite) / sizeof(seeSuite[0]) << " see tests passed"
+       << std::endl;
+
+    // every capture in the bench positions, as the move picker sees them
+    ChessBoard boards[BENCH_POSITIONS];
+    MoveList captures[BENCH_POSITIONS];
+    int count = 0, losing = 0;
+    for (int i = 0; i < BENCH_POSITIONS; i++) {
+        boards[i].setFen(benchPositions[i]);
+        boards[i].generateCaptures(captures[i]);
+        count += captures[i].size();
+        for (ChessMove move : captures[i]) losing += !boards[i].see(move);
+    }
+
+    long long sum = 0;
+    const steady_clock::time_point start = steady_clock::now();
+    for (int n = 0; n < iterations; n++)
+        for (int i = 0; i < BENCH_POSITIONS; i++)
+            for (ChessMove move : captures[i]) sum += boards[i].see(move);
+    const double ns =
+        std::chrono::duration<double, std::nano>(steady_clock::now() - start)
+            .count();
+
+    os << std::fixed << std::setprecision(1) << count << " captures, "
+       << losing << " losing, " << ns / (double(iterations) * count)
+       << " ns per see (checksum " << sum << ")" << std::endl;
+    return failures;
+}
+
+enum GameResult { BlackWins, WhiteWins, Draw };
+
+// games still running after this many plies are scored as draws
+const int MAX_GAME_LENGTH = 400;
+
+static GameResult playGame(const char *fen, Engine &white, Engine &black,
+                           int movetime) {
+    ChessBoard board;
+    board.setFen(fen);
+    white.clearHash();
+    black.clearHash();
+
+    SearchLimits limits;
+    limits.movetime = movetime;
+
+    for (int ply = 0; ply < MAX_GAME_LENGTH; ply++) {
+        MoveList moves;
+        board.generateLegalMoves(moves);
+        if (moves.empty()) {
+            if (!board.isInCheck(board.activeColor)) return Draw;
+            return board.activeColor == White ? BlackWins : WhiteWins;
+        }
+        if (board.halfmoves() >= 100 || board.isRepetition()) return Draw;
+
+        Engine &engine = board.activeColor == White ? white : black;
+        board.makeMove(engine.search(board, limits));
+    }
+    return Draw;
+}
+
+void playMatch(int threadsA, int threadsB, int games, int movetime,
+               std::ostream &os) {
+    Engine a, b;
+    a.setThreads(threadsA);
+    b.setThreads(threadsB);
+
+    const int positions = BENCH_POSITIONS;
+    int wins = 0, losses = 0, draws = 0;
+    for (int game = 0; game < games; game++) {
+        const char *fen = benchPositions[(game / 2) % positions];
+        const bool aIsWhite = game % 2 == 0;
+        const GameResult result = aIsWhite ? playGame(fen, a, b, movetime)
+                                           : playGame(fen, b, a, movetime);
+
+        if (result == Draw)
+            draws++;
+        else if ((result == WhiteWins) == aIsWhite)
+            wins++;
+        else
+            losses++;
+        os << "game " << game + 1 << ": +" << wins << " -" << losses << " ="
+           << draws << std::endl;
+    }
+
+    // logistic Elo from the score, with a 95% margin from its deviation
+    const double n = wins + losses + draws;
+    const double score = (wins + draws / 2.0) / n;
+    const double variance =
+        (wins * (1 - score) * (1 - score) + losses * score * score +
+         draws * (0.5 - score) * (0.5 - score)) /
+        n;
+    const double margin = 1.96 * std::sqrt(variance / n);
+    os << std::fixed << std::setprecision(1) << "threads " << threadsA
+       << " vs " << threadsB << ": score " << 100 * score << "%";
+
+    if (score <= 0 || score >= 1) {
+        os << ", elo not measurable" << std::endl;
+        return;
+    }
+    const double elo = -400 * std::log10(1 / score - 1);
+    const double upper =
+        -400 * std::log10(1 / std::min(0.999, score + margin) - 1);
+    os << ", elo " << elo << " +/- " << upper - elo << std::endl;
+}
+
+// parses "1,2,4,8" into thread counts
+static std::vector<int> parseList(const char *list) {
+    std::vector<int> values;
+    while (*list) {
+        values.push_back(std::max(1, atoi(list)));
+        const char *comma = strchr(list, ',');
+        if (!comma) break;
+        list = comma + 1;
+    }
+    return values;
+}
+
+int benchCommand(int argc, char **argv) {
+    if (argc > 0 && !strcmp(argv[0], "eval")) {
+        int iterations = 1000000;
+        for (int i = 1; i < argc; i++) {
+            if (!strcmp(argv[i], "--nnue") && i + 1 < argc) {
+                if (!loadNetwork(argv[++i])) {
+                    std::cout << "cannot load network: " << argv[i]
+                              << std::endl;
+                    return 1;
+                }
+            } else
+                iterations = std::max(1, atoi(argv[i]));
+        }
+        benchEval(iterations, std::cout);
+        return 0;
+    }
+    if (argc > 0 && !strcmp(argv[0], "selective")) {
+        benchSelective(argc > 1 ? std::max(1, atoi(argv[1])) : 8, std::cout);
+        return 0;
+    }
+    if (argc > 0 && !strcmp(argv[0], "see"))
+        return benchSee(argc > 1 ? std::max(1, atoi(argv[1])) : 1000000,
+                        std::cout) > 0;
+
+    int depth = 8;
+    std::vector<int> threads = {1, 2, 4, 8, 16};
+    for (int i = 0; i < argc; i++) {
+        if (!strcmp(argv[i], "--threads") && i + 1 < argc)
+            threads = parseList(argv[++i]);
+        else
+            depth = atoi(argv[i]);
+    }
+
+    if (depth < 1 || threads.empty()) {
+        std::cout << "usage: chess bench [depth] [--threads 1,2,4,...]"
+                  << std::endl;
+        return 1;
+    }
+    benchSearch(depth, threads, std::cout);
+    return 0;
+}
+
+int matchCommand(int argc, char **argv) {
+    int threadsA = 2, threadsB = 1, games = 16, movetime = 100;
+    for (int i = 0; i < argc; i++) {
+        const char *option = argv[i];
+        if (!strcmp(option, "--threads") && i + 2 < argc) {
+            threadsA = atoi(argv[++i]);
+            threadsB = atoi(argv[++i]);
+        } else if (!strcmp(option, "--games") && i + 1 < argc) {
+            games = atoi(argv[++i]);
+        } else if (!strcmp(option, "--movetime") && i + 1 < argc) {
+            movetime = atoi(argv[++i]);
+        } else {
+            games = 0;
+            break;
+        }
+    }
+
+    if (threadsA < 1 || threadsB < 1 || games < 1 || movetime < 1) {
+        std::cout << "usage: chess match [--threads a b] [--games n] "
+                     "[--movetime ms]"
+                  << std::endl;
+        return 1;
+    }
+    playMatch(threadsA, threadsB, games, movetime, std::cout);
+    return 0;
+}
@@ -0,0 +1,43 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <iosfwd>
+#include <vector>
+
+// searches a fixed set of positions to the given depth once for every
+// thread count, printing time to depth, nodes and speedup over the first
+// count; returns the total time in ms
+int benchSearch(int depth, const std::vector<int> &threads, std::ostream &);
+
+// searches the bench positions to the given depth with plain alpha-beta,
+// with every selective feature, and with each feature switched off in turn,
+// printing time to depth, nodes and effective branching factor for each;
+// returns the total time in ms
+int benchSelective(int depth, std::ostream &);
+
+// evaluates every bench position the given number of times and prints
+// the score of each and the average nanoseconds per evaluation; with a
+// network loaded, times it under every available kernel as well and checks
+// that they agree
+void benchEval(int iterations, std::ostream &);
+
+// checks static exchange evaluation against a suite of known values, then
+// times it over every capture in the bench positions; returns the number
+// of failed tests
+int benchSee(int iterations, std::ostream &);
+
+// plays pairs of games from the bench positions, each side once with
+// either colour, between an engine on threadsA and one on threadsB, and
+// prints the score and Elo difference of A
+void playMatch(int threadsA, int threadsB, int games, int movetime,
+               std::ostream &);
+
+// entry point for "chess bench [depth] [--threads 1,2,4,...]",
+// "chess bench eval [iterations] [--nnue file]" and
+// "chess bench selective [depth]" and "chess bench see [iterations]"
+int benchCommand(int argc, char **argv);
+
+// entry point for "chess match [--threads a b] [--games n] [--movetime ms]"
+int matchCommand(int argc, char **argv);
+
+#endif
@@ -0,0 +1,200 @@
+#include "Bitboard.h"
+
+#include <chrono>
+#include <initializer_list>
+#include <iostream>
+
+#include "ChessPiece.h"
+#include "Position.h"
+
+Bitboard pawnAttacks[2][64];
+Bitboard knightAttacks[64];
+Bitboard kingAttacks[64];
+Bitboard rays[8][64];
+Bitboard betweenBB[64][64];
+Bitboard lineBB[64][64];
+
+Magic rookMagics[64];
+Magic bishopMagics[64];
+
+// every square's attack sets are stored back to back; the sizes are the
+// sums over all squares of 2^(relevant occupancy bits)
+static Bitboard rookTable[0x19000];
+static Bitboard bishopTable[0x1480];
+
+static long long tableBuildMicros = 0;
+
+// directions that walk towards higher square numbers
+static bool increasing(int direction) {
+    return direction == D || direction == DR || direction == R ||
+           direction == DL;
+}
+
+static Bitboard rayAttacks(int direction, int sq, Bitboard occupied) {
+    Bitboard attacks = rays[direction][sq];
+    Bitboard blockers = attacks & occupied;
+    if (!blockers) return attacks;
+
+    const int blocker = increasing(direction) ? lsb(blockers) : msb(blockers);
+    return attacks ^ rays[direction][blocker];
+}
+
+static Bitboard slowAttacks(const int directions[4], int sq,
+                            Bitboard occupied) {
+    Bitboard attacks = 0;
+    for (int i = 0; i < 4; i++)
+        attacks |= rayAttacks(directions[i], sq, occupied);
+    return attacks;
+}
+
+#ifndef __BMI2__
+// few bits set, which makes good magic candidates; seeded per rank so the
+// search finishes quickly and deterministically
+static Bitboard sparseRandom64(Bitboard &state) {
+    return random64(state) & random64(state) & random64(state);
+}
+
+// searches for a multiplier that maps every occupancy subset to a slot that
+// is either unused or already holds the same attack set
+static void findMagic(Magic &m, const Bitboard occupancy[],
+                      const Bitboard reference[], int size, Bitboard seed) {
+    static int epoch[4096] = {0}, attempt = 0;
+
+    for (int i = 0; i < size;) {
+        for (m.magic = 0; popCount((m.magic * m.mask) >> 56) < 6;)
+            m.magic = sparseRandom64(seed);
+
+        for (++attempt, i = 0; i < size; i++) {
+            const unsigned idx = m.index(occupancy[i]);
+            if (epoch[idx] < attempt) {
+                epoch[idx] = attempt;
+                m.attacks[idx] = reference[i];
+            } else if (m.attacks[idx] != reference[i])
+                break;
+        }
+    }
+}
+#endif
+
+static void initMagics(Magic magics[64], Bitboard *table,
+                       const int directions[4]) {
+    static const Bitboard seeds[8] = {728,  2985, 2409, 2501,
+                                      1289, 2821, 1699, 255};
+    Bitboard occupancy[4096], reference[4096];
+
+    for (int sq = 0; sq < 64; sq++) {
+        Magic &m = magics[sq];
+
+        // the last square of each ray never blocks anything behind it, so
+        // it is left out of the relevant occupancy
+        m.mask = 0;
+        for (int i = 0; i < 4; i++) {
+            const Bitboard ray = rays[directions[i]][sq];
+            if (!ray) continue;
+            const int end = increasing(directions[i]) ? msb(ray) : lsb(ray);
+            m.mask |= ray & ~squareBB(end);
+        }
+        m.magic = 0;
+        m.shift = 64 - popCount(m.mask);
+        m.attacks = sq == 0 ? table
+                            : magics[sq - 1].attacks +
+                                  (Bitboard(1) << (64 - magics[sq - 1].shift));
+
+        // enumerate every subset of the mask (Carry-Rippler)
+        int size = 0;
+        Bitboard subset = 0;
+        do {
+            occupancy[size] = subset;
+            reference[size] = slowAttacks(directions, sq, subset);
+            size++;
+            subset = (subset - m.mask) & m.mask;
+        } while (subset);
+
+#ifdef __BMI2__
+        (void)seeds;
+        for (int i = 0; i < size; i++)
+            m.attacks[m.index(occupancy[i])] = reference[i];
+#else
+        findMagic(m, occupancy, reference, size, seeds[rankOf(sq)]);
+#endif
+    }
+}
+
+static bool buildTables() {
+    auto start = std::chrono::steady_clock::now();
+
+    for (int sq = 0; sq < 64; sq++) {
+        Position origin = positionOf(sq);
+
+        for (int direction = D; direction <= DL; direction++) {
+            Move move = basicMoves[direction];
+            if (origin.canGo(move))
+                kingAttacks[sq] |= squareBB(square(origin.go(move)));
+
+            for (Position pos = origin; pos.canGo(move);) {
+                pos = pos.go(move);
+                rays[direction][sq] |= squareBB(square(pos));
+            }
+        }
+
+        for (Move move : knightMoves)
+            if (origin.canGo(move))
+                knightAttacks[sq] |= squareBB(square(origin.go(move)));
+
+        // white pawns advance towards rank 8, i.e. up the board
+        for (Move move : {basicMoves[UL], basicMoves[UR]})
+            if (origin.canGo(move))
+                pawnAttacks[White][sq] |= squareBB(square(origin.go(move)));
+
+        for (Move move : {basicMoves[DL], basicMoves[DR]})
+            if (origin.canGo(move))
+                pawnAttacks[Black][sq] |= squareBB(square(origin.go(move)));
+    }
+
+    // opposite directions are four apart in basicMoves
+    for (int sq = 0; sq < 64; sq++)
+        for (int direction = D; direction <= DL; direction++)
+            for (Bitboard b = rays[direction][sq]; b;) {
+                const int to = popLsb(b);
+                betweenBB[sq][to] = rays[direction][sq] &
+                                    ~rays[direction][to] & ~squareBB(to);
+                lineBB[sq][to] = rays[direction][sq] |
+                                 rays[(direction + 4) % 8][sq] | squareBB(sq);
+            }
+
+    const int straight[4] = {U, D, L, R};
+    const int diagonal[4] = {UL, UR, DL, DR};
+    initMagics(rookMagics, rookTable, straight);
+    initMagics(bishopMagics, bishopTable, diagonal);
+
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    tableBuildMicros =
+        std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+    return true;
+}
+
+void initBitboards() {
+    static const bool built = buildTables();
+    (void)built;
+}
+
+void reportAttackTables(std::ostream &os) {
+    initBitboards();
+
+    const size_t leaperBytes = sizeof(pawnAttacks) + sizeof(knightAttacks) +
+                               sizeof(kingAttacks) + sizeof(rays);
+    const size_t sliderBytes = sizeof(rookTable) + sizeof(bishopTable) +
+                               sizeof(rookMagics) + sizeof(bishopMagics);
+#ifdef __BMI2__
+    os << "slider index:   pext\n";
+#else
+    os << "slider index:   magic\n";
+#endif
+    os << "rook entries:   " << sizeof(rookTable) / sizeof(Bitboard) << '\n';
+    os << "bishop entries: " << sizeof(bishopTable) / sizeof(Bitboard) << '\n';
+    os << "slider tables:  " << sliderBytes / 1024 << " KiB\n";
+    os << "leaper tables:  " << leaperBytes / 1024 << " KiB\n";
+    os << "line tables:    " << (sizeof(betweenBB) + sizeof(lineBB)) / 1024
+       << " KiB\n";
+    os << "build time:     " << tableBuildMicros << " us" << std::endl;
+}
@@ -0,0 +1,101 @@
+#ifndef BITBOARD_H
+#define BITBOARD_H
+
+#include <cstdint>
+#ifdef __BMI2__
+#include <immintrin.h>
+#endif
+#include <iosfwd>
+
+#include "Position.h"
+
+typedef uint64_t Bitboard;
+
+// squares are numbered in board order, matching Position: A8 = 0, H8 = 7,
+// A1 = 56, H1 = 63
+inline int square(int rank, int file) { return rank * 8 + file; }
+inline int square(const Position &position) {
+    return square(position.rank(), position.file());
+}
+inline int rankOf(int sq) { return sq >> 3; }
+inline int fileOf(int sq) { return sq & 7; }
+inline Position positionOf(int sq) { return Position(rankOf(sq), fileOf(sq)); }
+
+inline Bitboard squareBB(int sq) { return Bitboard(1) << sq; }
+inline Bitboard rankBB(int rank) { return Bitboard(0xFF) << (8 * rank); }
+inline Bitboard fileBB(int file) { return 0x0101010101010101ULL << file; }
+inline Bitboard shift(Bitboard b, int delta) {
+    return delta > 0 ? b << delta : b >> -delta;
+}
+inline int popCount(Bitboard b) { return __builtin_popcountll(b); }
+inline int lsb(Bitboard b) { return __builtin_ctzll(b); }
+inline int msb(Bitboard b) { return 63 - __builtin_clzll(b); }
+inline int popLsb(Bitboard &b) {
+    const int sq = lsb(b);
+    b &= b - 1;
+    return sq;
+}
+
+// xorshift64* pseudo-random numbers, for reproducible table generation
+inline uint64_t random64(uint64_t &state) {
+    state ^= state >> 12;
+    state ^= state << 25;
+    state ^= state >> 27;
+    return state * 2685821657736338717ULL;
+}
+
+// leaper attacks, indexed by square (pawns additionally by Color)
+extern Bitboard pawnAttacks[2][64];
+extern Bitboard knightAttacks[64];
+extern Bitboard kingAttacks[64];
+
+// empty-board rays, indexed by basicMoves direction
+extern Bitboard rays[8][64];
+
+// for two squares on a common rank, file or diagonal: the squares strictly
+// between them, and the whole line through both; empty otherwise
+extern Bitboard betweenBB[64][64];
+extern Bitboard lineBB[64][64];
+
+// sliding attacks are looked up in tables indexed by the relevant
+// occupancy: with BMI2 (build with -mbmi2 or -march=native) the index is a
+// PEXT of the occupancy, otherwise a magic multiply-and-shift
+struct Magic {
+    Bitboard mask;
+    Bitboard magic;
+    Bitboard *attacks;
+    unsigned shift;
+
+    unsigned index(Bitboard occupied) const {
+#ifdef __BMI2__
+        return _pext_u64(occupied, mask);
+#else
+        return unsigned(((occupied & mask) * magic) >> shift);
+#endif
+    }
+};
+
+extern Magic rookMagics[64];
+extern Magic bishopMagics[64];
+
+inline Bitboard rookAttacks(int sq, Bitboard occupied) {
+    const Magic &m = rookMagics[sq];
+    return m.attacks[m.index(occupied)];
+}
+
+inline Bitboard bishopAttacks(int sq, Bitboard occupied) {
+    const Magic &m = bishopMagics[sq];
+    return m.attacks[m.index(occupied)];
+}
+
+inline Bitboard queenAttacks(int sq, Bitboard occupied) {
+    return rookAttacks(sq, occupied) | bishopAttacks(sq, occupied);
+}
+
+// builds the attack tables, safe to call more than once
+void initBitboards();
+
+// prints the slider indexing scheme, table sizes and build time
+void reportAttackTables(std::ostream &);
+
+#endif
@@ -0,0 +1,62 @@
+#ifndef BOOK_H
+#define BOOK_H
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+
+#include "ChessBoard.h"
+#include "ChessMove.h"
+
+// the position's key in Polyglot books, which hash it their own way: en
+// passant counts only when a pawn can take, and the side bit is white's
+uint64_t polyglotKey(const ChessBoard &);
+
+// a book move and how often it should be played relative to the others
+struct BookMove {
+    ChessMove move;
+    int weight;
+};
+
+// a read-only memory-mapped Polyglot opening book: 16-byte big-endian
+// entries of key, move, weight and learning data, sorted by key, so a
+// position's moves are found by binary search without reading the book
+class PolyglotBook {
+   public:
+    PolyglotBook();
+    PolyglotBook(const PolyglotBook &) = delete;
+    PolyglotBook &operator=(const PolyglotBook &) = delete;
+    ~PolyglotBook();
+
+    // maps the book, replacing any open before; false if it cannot be read
+    // or is not a whole number of entries
+    bool open(const char *path);
+    void close();
+    bool isOpen() const;
+    // entries in the book
+    size_t size() const;
+
+    // the legal moves the book has for the position, in the book's order
+    // (heaviest first as books are written), into moves, which must hold
+    // MAX_MOVES; returns how many
+    int probe(const ChessBoard &, BookMove *moves) const;
+    // one of them, at random in proportion to weight or the heaviest when
+    // best is set, drawing on seed; a null move when out of book
+    ChessMove pick(const ChessBoard &, bool best, uint64_t &seed) const;
+
+   private:
+    const unsigned char *data;
+    size_t entries;
+};
+
+// compiles the first plies of every game of a PGN archive into a book,
+// each move weighted two for every game the side playing it won and one
+// for every draw; moves only ever played in lost games are left out
+bool buildBook(const char *pgn, const char *out, int plies, int threads,
+               std::ostream &);
+
+// entry point for "chess book <file> [fen]" and
+// "chess book build <pgn> <file> [--plies n] [--threads n]"
+int bookCommand(int argc, char **argv);
+
+#endif
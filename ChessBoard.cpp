@@ -1,94 +1,693 @@
 #include "ChessBoard.h"
 
+#include <algorithm>
 #include <cassert>
+#include <cctype>
 #include <cstring>
+#include <initializer_list>
 #include <iostream>
 
 #include "ChessPiece.h"
 #include "Position.h"
+#include "Psqt.h"
+#include "Zobrist.h"
 
-ChessBoard::ChessBoard() : activeColor(White) {
-    for (int i = 0; i < 8; i++)
-        for (int j = 0; j < 8; j++) movePiece(NULL, Position(i, j));
-
+ChessBoard::ChessBoard()
+    : activeColor(White), output(&std::cout), style(Ascii) {
+    initBitboards();
+    initZobrist();
+    initPsqt();
+    clearPieces();
     initialiseBoard();
 }
 
-void ChessBoard::printBoard() {
-    for (int i = 0; i < 8; i++) {
-        std::cout << 8 - i << "  ";
-        for (int j = 0; j < 8; j++) {
-            std::cout << getPiece(Position(i, j)) << " ";
+// every copy owns its own pieces, including the captured ones still held
+// in the history, so copies can be played and unwound independently
+ChessBoard::ChessBoard(const ChessBoard &other) { copyPieces(other); }
+
+ChessBoard &ChessBoard::operator=(const ChessBoard &other) {
+    if (this != &other) copyPieces(other);
+    return *this;
+}
+
+ChessBoard::~ChessBoard() {}
+
+void ChessBoard::setOutput(std::ostream *os, RenderStyle renderStyle) {
+    output = os;
+    style = renderStyle;
+}
+
+// glyphs indexed by [color][type], as UTF-8
+static const char *const glyphs[2][6] = {
+    {"\u265F", "\u265C", "\u265E", "\u265D", "\u265A", "\u265B"},
+    {"\u2659", "\u2656", "\u2658", "\u2657", "\u2654", "\u2655"}};
+
+static char *append(char *out, const char *text) {
+    while (*text) *out++ = *text++;
+    return out;
+}
+
+int ChessBoard::render(char *buf, RenderStyle renderStyle) const {
+    char *out = buf;
+    if (renderStyle == Fen) {
+        out += strlen(toFen(out));
+        *out++ = '\n';
+        *out = '\0';
+        return out - buf;
+    }
+
+    char name[3];
+    for (int rank = 0; rank < 8; rank++) {
+        *out++ = '8' - rank;
+        *out++ = ' ';
+        if (renderStyle == Ascii) *out++ = ' ';
+        for (int file = 0; file < 8; file++) {
+            const ChessPiece *piece = board[rank][file];
+            if (renderStyle == Unicode)
+                out = append(out, piece ? glyphs[piece->color()][piece->type()]
+                                        : "\u00B7");
+            else
+                out = append(out, piece ? piece->str(name) : "__");
+            *out++ = ' ';
+        }
+        *out++ = '\n';
+    }
+
+    if (renderStyle == Unicode) {
+        out = append(out, "  a b c d e f g h\n");
+    } else {
+        out = append(out, "\n   ");
+        for (int file = 0; file < 8; file++) {
+            *out++ = 'A' + file;
+            out = append(out, "  ");
         }
-        std::cout << std::endl;
+        out = append(out, "\n\n\n");
     }
+    *out = '\0';
+    return out - buf;
+}
 
-    std::cout << "\n   ";
-    for (int i = 0; i < 8; i++) std::cout << static_cast<char>('A' + i) << "  ";
-    std::cout << "\n\n" << std::endl;
+void ChessBoard::render(std::string &out, RenderStyle renderStyle) const {
+    char buf[MAX_RENDER];
+    out.assign(buf, render(buf, renderStyle));
 }
-void ChessBoard::movePiece(ChessPiece *piece, Position position) const {
+
+void ChessBoard::printBoard() const {
+    if (!output) return;
+    char buf[MAX_RENDER];
+    output->write(buf, render(buf, style));
+    output->flush();
+}
+
+void ChessBoard::movePiece(ChessPiece *piece, Position position) {
+    // whatever was standing on the destination leaves the bitboards
+    ChessPiece *occupant = board[position.rank()][position.file()];
+    if (occupant) toggle(occupant, square(position));
+
     if (piece) {
         Position origin = piece->position();
-        board[origin.rank()][origin.file()] = NULL;
+        if (board[origin.rank()][origin.file()] == piece) {
+            board[origin.rank()][origin.file()] = NULL;
+            toggle(piece, square(origin));
+        }
         piece->setPosition(position);
+        toggle(piece, square(position));
     }
 
     board[position.rank()][position.file()] = piece;
 }
 
+void ChessBoard::toggle(ChessPiece *piece, int sq) {
+    const Bitboard bb = squareBB(sq);
+    const Color color = piece->color();
+    const Type type = piece->type();
+    if (pieces[color][type] & bb) {
+        psq -= pieceSquare[color][type][sq];
+        phase -= phaseWeight[type];
+        if (nnueActive) removeFeature(nnue, color, type, sq);
+    } else {
+        psq += pieceSquare[color][type][sq];
+        phase += phaseWeight[type];
+        if (nnueActive) addFeature(nnue, color, type, sq);
+    }
+
+    pieces[color][type] ^= bb;
+    colors[color] ^= bb;
+    occupied ^= bb;
+    key ^= pieceKeys[color][type][sq];
+    if (type == tPawn) pawnKey ^= pieceKeys[color][tPawn][sq];
+}
+
+uint64_t ChessBoard::hash() const { return key; }
+uint64_t ChessBoard::pawnHash() const { return pawnKey; }
+
+// the part of the key that is not pieces or side to move. The en passant
+// file only counts when a pawn can actually make the capture, so that
+// otherwise identical positions share a key.
+uint64_t ChessBoard::stateKey() const {
+    uint64_t state = castlingKeys[castlingRights];
+    if (epSquare >= 0 &&
+        (pawnAttacks[opposite(activeColor)][epSquare] &
+         pieces[activeColor][tPawn]))
+        state ^= epKeys[fileOf(epSquare)];
+    return state;
+}
+
+uint64_t ChessBoard::computeKey() const {
+    uint64_t computed = stateKey();
+    if (activeColor == Black) computed ^= sideKey;
+
+    for (Color color : {Black, White})
+        for (int type = tPawn; type <= tQueen; type++)
+            for (Bitboard b = pieces[color][type]; b;)
+                computed ^= pieceKeys[color][type][popLsb(b)];
+    return computed;
+}
+
+uint64_t ChessBoard::computePawnKey() const {
+    uint64_t computed = 0;
+    for (Color color : {Black, White})
+        for (Bitboard b = pieces[color][tPawn]; b;)
+            computed ^= pieceKeys[color][tPawn][popLsb(b)];
+    return computed;
+}
+
+Score ChessBoard::psqScore() const { return psq; }
+int ChessBoard::gamePhase() const { return phase; }
+
+Score ChessBoard::computePsq() const {
+    Score computed = 0;
+    for (Color color : {Black, White})
+        for (int type = tPawn; type <= tQueen; type++)
+            for (Bitboard b = pieces[color][type]; b;)
+                computed += pieceSquare[color][type][popLsb(b)];
+    return computed;
+}
+
+void ChessBoard::refreshAccumulator() {
+    nnueActive = nnueEnabled();
+    if (nnueActive) ::refreshAccumulator(nnue, pieces);
+}
+
+const Accumulator *ChessBoard::accumulator() const {
+    return nnueActive ? &nnue : NULL;
+}
+
+bool ChessBoard::accumulatorMatches() const {
+    if (!nnueActive) return true;
+    Accumulator fresh;
+    ::refreshAccumulator(fresh, pieces);
+    return !memcmp(&fresh, &nnue, sizeof(nnue));
+}
+
+ChessMove ChessBoard::lastMove() const {
+    return ply ? ChessMove(history[ply - 1].move) : ChessMove();
+}
+
+bool ChessBoard::isRepetition() const {
+    const int earliest = std::max(0, ply - halfmoveClock);
+    for (int i = ply - 4; i >= earliest; i -= 2)
+        if (history[i].key == key) return true;
+    return false;
+}
+
+ChessPiece *ChessBoard::pieceAt(int sq) const {
+    return board[rankOf(sq)][fileOf(sq)];
+}
+
 ChessPiece *ChessBoard::getPiece(Position position) const {
+    if (!(occupied & squareBB(square(position)))) return NULL;
     return board[position.rank()][position.file()];
 }
 
+Bitboard ChessBoard::occupancy() const { return occupied; }
+Bitboard ChessBoard::occupancy(Color color) const { return colors[color]; }
+Bitboard ChessBoard::occupancy(Color color, Type type) const {
+    return pieces[color][type];
+}
+int ChessBoard::halfmoves() const { return halfmoveClock; }
+int ChessBoard::fullmoves() const { return fullmoveNumber; }
+bool ChessBoard::canCastle() const { return castlingRights != 0; }
+
 bool ChessBoard::checkMove(Position origin, Position destination,
                            Color color) const {
-    ChessPiece *originPiece = getPiece(origin);
-    ChessPiece *capturedPiece = move(origin, destination);
-    bool check = isInCheck(color);
-    movePiece(originPiece, origin);
-    originPiece->decrementMoveCount();
-    if (capturedPiece) movePiece(capturedPiece, capturedPiece->position());
-    return !check;
-}
-
-ChessPiece *ChessBoard::move(Position origin, Position destination) const {
-    ChessPiece *originPiece = getPiece(origin);
-    ChessPiece *destinationPiece = getPiece(destination);
-
-    originPiece->incrementMoveCount();
-    // must be en passant
-    if ((originPiece->type() == tPawn) && !destinationPiece &&
-        origin.file() != destination.file()) {
-        const int priorRank = destination.rank() + (activeColor ? 1 : -1);
-        ChessPiece *capturedPiece =
-            getPiece(Position(priorRank, destination.file()));
-        movePiece(originPiece, Position(destination));
-        movePiece(NULL, capturedPiece->position());
-        return capturedPiece;
-    }
-
-    // must be castling
-    if (originPiece->type() == tKing &&
-        abs(origin.file() - destination.file()) == 2) {
-        int fileDiff = origin.file() - destination.file();
-
-        // get corresdponding rook
-        ChessPiece *rook = NULL;
-        if (fileDiff > 0)
-            rook = getPiece(Position(activeColor ? "A1" : "A8"));
-        else
-            rook = getPiece(Position(activeColor ? "H1" : "H8"));
-
-        Move move = basicMoves[fileDiff > 0 ? R : L];
-        movePiece(originPiece, destination);
-        movePiece(rook, originPiece->position().go(move));
-        return NULL;
-    }
-
-    ChessPiece *capturedPiece = getPiece(Position(destination));
-    movePiece(originPiece, destination);
-    return capturedPiece;
+    ChessPiece *piece = getPiece(origin);
+    if (!piece || piece->color() != color) return false;
+    return !findMove(origin, destination).isNull();
+}
+
+// castling rights lost when a move starts or ends on a square
+static int castlingMask(int sq) {
+    switch (sq) {
+        case 0:  // A8
+            return BlackQueenSide;
+        case 4:  // E8
+            return BlackKingSide | BlackQueenSide;
+        case 7:  // H8
+            return BlackKingSide;
+        case 56:  // A1
+            return WhiteQueenSide;
+        case 60:  // E1
+            return WhiteKingSide | WhiteQueenSide;
+        case 63:  // H1
+            return WhiteKingSide;
+        default:
+            return 0;
+    }
+}
+
+static Type promotionType(ChessMove move) {
+    static const Type types[4] = {tKnight, tBishop, tRook, tQueen};
+    return types[move.flag() & 3];
+}
+
+void ChessBoard::makeMove(ChessMove move) {
+    assert(ply < MAX_GAME_PLY);
+    UndoInfo &undo = history[ply++];
+    undo.move = move.raw();
+    undo.captured = NULL;
+    undo.castlingRights = castlingRights;
+    undo.epSquare = epSquare;
+    undo.halfmoveClock = halfmoveClock;
+    undo.key = key;
+    undo.checkers = checkingPieces;
+    undo.pinned = pinnedPieces;
+    undo.threats = attackedSquares;
+    key ^= stateKey();
+
+    const int from = move.from(), to = move.to();
+    ChessPiece *piece = pieceAt(from);
+    const bool irreversible = piece->type() == tPawn || move.isCapture();
+
+    if (move.flag() == EnPassant) {
+        const int captured = to + (activeColor == White ? 8 : -8);
+        undo.captured = pieceAt(captured);
+        movePiece(NULL, positionOf(captured));
+    } else if (move.isCapture())
+        undo.captured = pieceAt(to);
+
+    movePiece(piece, positionOf(to));
+    piece->incrementMoveCount();
+
+    if (move.isCastle()) {
+        const bool kingSide = move.flag() == KingCastle;
+        ChessPiece *rook = pieceAt(kingSide ? to + 1 : to - 2);
+        movePiece(rook, positionOf(kingSide ? to - 1 : to + 1));
+        rook->incrementMoveCount();
+    }
+
+    if (move.isPromotion()) {
+        toggle(piece, to);
+        piece->setType(promotionType(move));
+        toggle(piece, to);
+    }
+
+    castlingRights &= ~(castlingMask(from) | castlingMask(to));
+    epSquare = move.flag() == DoublePush ? (from + to) / 2 : -1;
+    halfmoveClock = irreversible ? 0 : halfmoveClock + 1;
+    if (activeColor == Black) fullmoveNumber++;
+    activeColor = opposite(activeColor);
+    key ^= stateKey() ^ sideKey;
+    updateAttacks();
+
+#ifdef CHECK_HASH
+    assert(key == computeKey());
+    assert(pawnKey == computePawnKey());
+    assert(psq == computePsq());
+    assert(accumulatorMatches());
+#endif
+}
+
+// passes the turn, for null-move pruning. The halfmove clock restarts so
+// that no repetition is found across the null move.
+void ChessBoard::makeNullMove() {
+    assert(ply < MAX_GAME_PLY);
+    UndoInfo &undo = history[ply++];
+    undo.move = ChessMove().raw();
+    undo.captured = NULL;
+    undo.castlingRights = castlingRights;
+    undo.epSquare = epSquare;
+    undo.halfmoveClock = halfmoveClock;
+    undo.key = key;
+    undo.checkers = checkingPieces;
+    undo.pinned = pinnedPieces;
+    undo.threats = attackedSquares;
+
+    key ^= stateKey();
+    epSquare = -1;
+    halfmoveClock = 0;
+    if (activeColor == Black) fullmoveNumber++;
+    activeColor = opposite(activeColor);
+    key ^= stateKey() ^ sideKey;
+    updateAttacks();
+}
+
+void ChessBoard::unmakeNullMove() {
+    assert(ply > 0);
+    const UndoInfo &undo = history[--ply];
+    activeColor = opposite(activeColor);
+    if (activeColor == Black) fullmoveNumber--;
+    epSquare = undo.epSquare;
+    halfmoveClock = undo.halfmoveClock;
+    key = undo.key;
+    checkingPieces = undo.checkers;
+    pinnedPieces = undo.pinned;
+    attackedSquares = undo.threats;
+}
+
+void ChessBoard::unmakeMove() {
+    assert(ply > 0);
+    const UndoInfo &undo = history[--ply];
+    const ChessMove move(undo.move);
+    const int from = move.from(), to = move.to();
+    ChessPiece *piece = pieceAt(to);
+
+    activeColor = opposite(activeColor);
+    if (activeColor == Black) fullmoveNumber--;
+
+    if (move.isPromotion()) {
+        toggle(piece, to);
+        piece->setType(tPawn);
+        toggle(piece, to);
+    }
+
+    movePiece(piece, positionOf(from));
+    piece->decrementMoveCount();
+
+    if (move.isCastle()) {
+        const bool kingSide = move.flag() == KingCastle;
+        ChessPiece *rook = pieceAt(kingSide ? to - 1 : to + 1);
+        movePiece(rook, positionOf(kingSide ? to + 1 : to - 2));
+        rook->decrementMoveCount();
+    }
+
+    // the captured piece still remembers the square it was taken on
+    if (undo.captured) movePiece(undo.captured, undo.captured->position());
+
+    castlingRights = undo.castlingRights;
+    epSquare = undo.epSquare;
+    halfmoveClock = undo.halfmoveClock;
+    key = undo.key;
+    checkingPieces = undo.checkers;
+    pinnedPieces = undo.pinned;
+    attackedSquares = undo.threats;
+
+#ifdef CHECK_HASH
+    assert(key == computeKey());
+    assert(pawnKey == computePawnKey());
+    assert(psq == computePsq());
+    assert(accumulatorMatches());
+#endif
+}
+
+static void pushPromotions(MoveList &list, int from, int to, bool capture) {
+    const int base = capture ? CapturePromoteKnight : PromoteKnight;
+    for (int flag = base + 3; flag >= base; flag--)
+        list.push(ChessMove(from, to, flag));
+}
+
+template <GenType T>
+void ChessBoard::generate(MoveList &list, Color us) const {
+    const Color them = opposite(us);
+    const Bitboard enemy = colors[them];
+    const Bitboard targets =
+        T == Captures ? enemy : T == Quiets ? ~occupied : ~colors[us];
+
+    // pawns advance up the board (towards lower squares) for white
+    const int forward = us == White ? -8 : 8;
+    const Bitboard promotionRank = rankBB(us == White ? 0 : 7);
+    const Bitboard pushRank = rankBB(us == White ? 5 : 2);
+    const Bitboard pawns = pieces[us][tPawn];
+    const Bitboard single = shift(pawns, forward) & ~occupied;
+
+    if (T != Captures) {
+        Bitboard pushes = single & ~promotionRank;
+        Bitboard doubles = shift(single & pushRank, forward) & ~occupied;
+        while (pushes) {
+            const int to = popLsb(pushes);
+            list.push(ChessMove(to - forward, to, Quiet));
+        }
+        while (doubles) {
+            const int to = popLsb(doubles);
+            list.push(ChessMove(to - 2 * forward, to, DoublePush));
+        }
+    }
+
+    if (T != Quiets) {
+        Bitboard promotions = single & promotionRank;
+        while (promotions) {
+            const int to = popLsb(promotions);
+            pushPromotions(list, to - forward, to, false);
+        }
+
+        for (Bitboard b = pawns; b;) {
+            const int from = popLsb(b);
+            Bitboard captures = pawnAttacks[us][from] & enemy;
+            while (captures) {
+                const int to = popLsb(captures);
+                if (squareBB(to) & promotionRank)
+                    pushPromotions(list, from, to, true);
+                else
+                    list.push(ChessMove(from, to, Capture));
+            }
+        }
+
+        if (epSquare >= 0 && us == activeColor) {
+            Bitboard attackers = pawnAttacks[them][epSquare] & pawns;
+            while (attackers)
+                list.push(ChessMove(popLsb(attackers), epSquare, EnPassant));
+        }
+    }
+
+    for (int type = tRook; type <= tQueen; type++) {
+        for (Bitboard b = pieces[us][type]; b;) {
+            const int from = popLsb(b);
+            Bitboard attacks = 0;
+            switch (type) {
+                case tRook:
+                    attacks = rookAttacks(from, occupied);
+                    break;
+                case tKnight:
+                    attacks = knightAttacks[from];
+                    break;
+                case tBishop:
+                    attacks = bishopAttacks(from, occupied);
+                    break;
+                case tKing:
+                    attacks = kingAttacks[from];
+                    break;
+                case tQueen:
+                    attacks = queenAttacks(from, occupied);
+                    break;
+            }
+
+            attacks &= targets;
+            while (attacks) {
+                const int to = popLsb(attacks);
+                const bool capture = enemy & squareBB(to);
+                list.push(ChessMove(from, to, capture ? Capture : Quiet));
+            }
+        }
+    }
+
+    if (T == Captures) return;
+
+    // castling: the squares between king and rook must be empty and the
+    // king may not start on, cross or land on an attacked square
+    const int kingSide = us == White ? WhiteKingSide : BlackKingSide;
+    const int queenSide = us == White ? WhiteQueenSide : BlackQueenSide;
+    const int king = us == White ? 60 : 4;
+
+    if ((castlingRights & kingSide) &&
+        !(occupied & (squareBB(king + 1) | squareBB(king + 2))) &&
+        !(attackersTo(king, occupied) & enemy) &&
+        !(attackersTo(king + 1, occupied) & enemy) &&
+        !(attackersTo(king + 2, occupied) & enemy))
+        list.push(ChessMove(king, king + 2, KingCastle));
+
+    if ((castlingRights & queenSide) &&
+        !(occupied &
+          (squareBB(king - 1) | squareBB(king - 2) | squareBB(king - 3))) &&
+        !(attackersTo(king, occupied) & enemy) &&
+        !(attackersTo(king - 1, occupied) & enemy) &&
+        !(attackersTo(king - 2, occupied) & enemy))
+        list.push(ChessMove(king, king - 2, QueenCastle));
+}
+
+void ChessBoard::generateMoves(MoveList &list) const {
+    generate<AllMoves>(list, activeColor);
+}
+
+void ChessBoard::generateCaptures(MoveList &list) const {
+    generate<Captures>(list, activeColor);
+}
+
+void ChessBoard::generateQuiets(MoveList &list) const {
+    generate<Quiets>(list, activeColor);
+}
+
+void ChessBoard::generateLegalMoves(MoveList &list) const {
+    MoveList pseudo;
+    generate<AllMoves>(pseudo, activeColor);
+    for (ChessMove move : pseudo)
+        if (isLegal(move)) list.push(move);
+}
+
+// whether a pseudo-legal move leaves the mover's king safe, decided on the
+// bitboards without touching the board
+bool ChessBoard::isLegal(ChessMove move) const {
+    // the generator already checked every square the king crosses
+    if (move.isCastle()) return true;
+
+    const int from = move.from(), to = move.to();
+    const Color us = (colors[White] & squareBB(from)) ? White : Black;
+    const Color them = opposite(us);
+
+    // the side to move is checked against its pins, checkers and threats;
+    // en passant removes two pieces from a line and takes the long way
+    if (us == activeColor && move.flag() != EnPassant) {
+        const int king = lsb(pieces[us][tKing]);
+        if (from == king) return !(attackedSquares & squareBB(to));
+
+        if (checkingPieces) {
+            const int checker = lsb(checkingPieces);
+            if (checkingPieces != squareBB(checker)) return false;
+            if (!((betweenBB[king][checker] | checkingPieces) & squareBB(to)))
+                return false;
+        }
+        return !(pinnedPieces & squareBB(from)) ||
+               (lineBB[king][from] & squareBB(to));
+    }
+
+    int captured = to;
+    if (move.flag() == EnPassant) captured = to + (us == White ? 8 : -8);
+
+    const Bitboard occupancy =
+        (occupied ^ squareBB(from) ^ squareBB(captured)) | squareBB(to);
+    const int king =
+        (squareBB(from) & pieces[us][tKing]) ? to : lsb(pieces[us][tKing]);
+
+    const Bitboard remaining = colors[them] & ~squareBB(captured);
+    return !(attackersTo(king, occupancy) & remaining);
+}
+
+bool ChessBoard::isPseudoLegal(ChessMove move) const {
+    if (move.isNull()) return false;
+    const int from = move.from(), to = move.to();
+    const ChessPiece *piece = pieceAt(from);
+    if (!piece || piece->color() != activeColor) return false;
+
+    // castling, en passant, double pushes and promotions are rare enough
+    // outside the generator to simply look them up
+    if (move.flag() != Quiet && move.flag() != Capture) {
+        MoveList list;
+        generate<AllMoves>(list, activeColor);
+        return std::find(list.begin(), list.end(), move) != list.end();
+    }
+
+    const Bitboard target = squareBB(to);
+    if (move.isCapture() ? !(colors[opposite(activeColor)] & target)
+                         : (occupied & target))
+        return false;
+
+    switch (piece->type()) {
+        case tPawn: {
+            // promotions carry their own flag
+            if (target & (rankBB(0) | rankBB(7))) return false;
+            if (move.isCapture())
+                return pawnAttacks[activeColor][from] & target;
+            return to == from + (activeColor == White ? -8 : 8);
+        }
+        case tRook:
+            return rookAttacks(from, occupied) & target;
+        case tKnight:
+            return knightAttacks[from] & target;
+        case tBishop:
+            return bishopAttacks(from, occupied) & target;
+        case tKing:
+            return kingAttacks[from] & target;
+        default:
+            return queenAttacks(from, occupied) & target;
+    }
+}
+
+// exchange values, indexed by Type; the king can only end an exchange
+static const int SEE_VALUE[6] = {100, 500, 325, 325, 0, 1000};
+// the order pieces join an exchange in, cheapest first
+static const Type SEE_ORDER[6] = {tPawn, tKnight, tBishop,
+                                  tRook, tQueen,  tKing};
+
+bool ChessBoard::see(ChessMove move, int threshold) const {
+    if (move.isCastle() || move.isPromotion() || move.flag() == EnPassant)
+        return 0 >= threshold;
+
+    const int from = move.from(), to = move.to();
+    const ChessPiece *victim = move.isCapture() ? pieceAt(to) : NULL;
+
+    // swap is what the side on move stands to win or lose in the exchange,
+    // from the point of view of whoever just captured
+    int swap = (victim ? SEE_VALUE[victim->type()] : 0) - threshold;
+    if (swap < 0) return false;
+    swap = SEE_VALUE[pieceAt(from)->type()] - swap;
+    if (swap <= 0) return true;
+
+    const Bitboard diagonal = pieces[Black][tBishop] | pieces[White][tBishop] |
+                              pieces[Black][tQueen] | pieces[White][tQueen];
+    const Bitboard straight = pieces[Black][tRook] | pieces[White][tRook] |
+                              pieces[Black][tQueen] | pieces[White][tQueen];
+    Bitboard occupancy = occupied ^ squareBB(from) ^ squareBB(to);
+    Bitboard attackers = attackersTo(to, occupancy);
+    Color side = pieceAt(from)->color();
+    bool winning = true;
+
+    for (;;) {
+        side = opposite(side);
+        attackers &= occupancy;
+        const Bitboard ours = attackers & colors[side];
+        if (!ours) break;
+        winning = !winning;
+
+        // recapture with the least valuable attacker; taking it off the
+        // board may uncover a slider behind it
+        Type type = tPawn;
+        for (Type candidate : SEE_ORDER)
+            if (ours & pieces[side][candidate]) {
+                type = candidate;
+                break;
+            }
+
+        if (type == tKing)
+            // the king may only take if nothing can take it back
+            return (attackers & colors[opposite(side)]) ? !winning : winning;
+
+        swap = SEE_VALUE[type] - swap;
+        if (swap < int(winning)) break;
+        occupancy ^= squareBB(lsb(ours & pieces[side][type]));
+
+        if (type == tPawn || type == tBishop || type == tQueen)
+            attackers |= bishopAttacks(to, occupancy) & diagonal;
+        if (type == tRook || type == tQueen)
+            attackers |= rookAttacks(to, occupancy) & straight;
+    }
+    return winning;
+}
+
+// the legal move taking the piece on origin to destination, or a null move
+// if there is none; pawns reaching the last rank promote to a queen
+ChessMove ChessBoard::findMove(Position origin, Position destination) const {
+    ChessPiece *piece = getPiece(origin);
+    if (!piece) return ChessMove();
+
+    const int from = square(origin), to = square(destination);
+    MoveList list;
+    generate<AllMoves>(list, piece->color());
+    for (ChessMove move : list) {
+        if (move.from() != from || move.to() != to) continue;
+        if (move.isPromotion() && promotionType(move) != tQueen) continue;
+        if (isLegal(move)) return move;
+    }
+
+    return ChessMove();
 }
 
 // for castling
@@ -103,149 +702,512 @@ void ChessBoard::submitMove(const char *castleCode) {
     else if (!strcmp(castleCode, "O-O-O"))
         submitMove(activeColor ? "E1" : "E8", activeColor ? "C1" : "C8");
 
-    else
-        std::cout << "invalid singleton move" << std::endl;
+    else if (output)
+        *output << "invalid singleton move" << std::endl;
 }
 
 void ChessBoard::submitMove(const char *origin, const char *destination) {
-    std::cout << origin << " " << destination << std::endl;
+    if (output) *output << origin << " " << destination << '\n';
     // verify that there is correctly colored piece at origin
     ChessPiece *activePiece = getPiece(Position(origin));
 
-    if (!activePiece) {
-        std::cout << "No Piece at requested position" << std::endl;
-        return;
-    }
-
-    if (activePiece->color() != activeColor) {
-        std::cout << "It is not their turn!" << std::endl;
+    const char *refusal = NULL;
+    if (!activePiece)
+        refusal = "No Piece at requested position";
+    else if (activePiece->color() != activeColor)
+        refusal = "It is not their turn!";
+    else if (ply == MAX_GAME_PLY)
+        refusal = "Game is too long to continue";
+    if (refusal) {
+        if (output) *output << refusal << std::endl;
         return;
     }
 
     // check piece can move to requested position
-    bool canMove = activePiece->verifyMove(this, Position(destination));
-    if (!canMove) return activePiece->reportInvalidMove(Position(destination));
-
-    ChessPiece *capturedPiece = move(Position(origin), Position(destination));
-    if (capturedPiece) delete capturedPiece;
-
-    // end game if opponent is in checkmate
-    if (isInCheckmate(activeColor ? Black : White)) {
-        std::cout << (activeColor ? "White" : "Black") << " is in checkmate"
-                  << std::endl;
+    ChessMove move = findMove(Position(origin), Position(destination));
+    if (move.isNull()) {
+        if (output) {
+            activePiece->reportInvalidMove(Position(destination), *output);
+            output->flush();
+        }
         return;
     }
 
-    // end game if opponent is in stalemate
-    if (isInStalemate(activeColor ? Black : White)) {
-        std::cout << (activeColor ? "White" : "Black") << " is in stalemate"
-                  << std::endl;
-        return;
-    }
+    // the captured piece is kept in the history rather than deleted
+    makeMove(move);
+    const Color opponent = activeColor;
+    if (!output) return;
 
-    // report check
-    if (isInCheck(activeColor ? Black : White))
-        std::cout << (activeColor ? "Black" : "White") << " is in check"
-                  << std::endl;
+    switch (status()) {
+        case Checkmate:
+        case Stalemate:
+            *output << (opponent ? "Black" : "White") << " is in "
+                    << (checkingPieces ? "checkmate" : "stalemate")
+                    << std::endl;
+            return;
+        case Check:
+            *output << (opponent ? "White" : "Black") << " is in check\n";
+            break;
+        default:
+            break;
+    }
 
-    // swtich turns
-    activeColor = activeColor ? Black : White;
     printBoard();
 }
 
 Color ChessBoard::opposite(Color color) { return color ? Black : White; }
 
 bool ChessBoard::isInCheck(Color color) const {
-    return isMarkedBy(king[color]->position(), opposite(color));
+    if (color == activeColor) return checkingPieces;
+    const int kingSquare = lsb(pieces[color][tKing]);
+    return attackersTo(kingSquare, occupied) & colors[opposite(color)];
 }
 
 bool ChessBoard::isMarkedBy(Position position, Color color) const {
-    for (Move move : basicMoves) {
-        Position pos = position;
-        while (pos.canGo(move)) {
-            pos = pos.go(move);
-            if (!getPiece(pos)) continue;
-            if (getPiece(pos)->color() != color) break;
-            if (getPiece(pos)->verifyMove(this, position)) return true;
-            break;
-        }
-    }
+    return attackersTo(square(position), occupied) & colors[color];
+}
 
-    for (Move move : knightMoves) {
-        if (!position.canGo(move)) continue;
-        Position pos = position.go(move);
-        if (!getPiece(pos) || getPiece(pos)->color() != color) continue;
-        if (getPiece(pos)->verifyMove(this, position)) return true;
-    }
+// every piece of either color attacking sq, given the occupancy
+Bitboard ChessBoard::attackersTo(int sq, Bitboard occupancy) const {
+    const Bitboard diagonal = pieces[Black][tBishop] | pieces[White][tBishop] |
+                              pieces[Black][tQueen] | pieces[White][tQueen];
+    const Bitboard straight = pieces[Black][tRook] | pieces[White][tRook] |
+                              pieces[Black][tQueen] | pieces[White][tQueen];
 
-    return false;
+    const Bitboard knights = pieces[Black][tKnight] | pieces[White][tKnight];
+    const Bitboard kings = pieces[Black][tKing] | pieces[White][tKing];
+
+    return (pawnAttacks[White][sq] & pieces[Black][tPawn]) |
+           (pawnAttacks[Black][sq] & pieces[White][tPawn]) |
+           (knightAttacks[sq] & knights) | (kingAttacks[sq] & kings) |
+           (bishopAttacks(sq, occupancy) & diagonal) |
+           (rookAttacks(sq, occupancy) & straight);
 }
 
 bool ChessBoard::isInStalemate(Color color) const {
-    for (int rank = 0; rank < 8; rank++)
-        for (int file = 0; file < 8; file++) {
-            ChessPiece *piece = getPiece(Position(rank, file));
-            if (!piece) continue;
-            if (piece->color() != color) continue;
-            if (piece->canMove(this)) return false;
-        }
+    if (color == activeColor) return !hasLegalMove();
+
+    MoveList list;
+    generate<AllMoves>(list, color);
+    for (ChessMove move : list)
+        if (isLegal(move)) return false;
 
     return true;
 }
 
 bool ChessBoard::isInCheckmate(Color color) const {
-    return isInStalemate(color) &&
-           isMarkedBy(king[color]->position(), opposite(color));
+    return isInStalemate(color) && isInCheck(color);
+}
+
+Bitboard ChessBoard::checkers() const { return checkingPieces; }
+Bitboard ChessBoard::pinned() const { return pinnedPieces; }
+Bitboard ChessBoard::threats() const { return attackedSquares; }
+
+Bitboard ChessBoard::attacks(Color color, Bitboard occupancy) const {
+    Bitboard attacked = kingAttacks[lsb(pieces[color][tKing])];
+    for (Bitboard b = pieces[color][tPawn]; b;)
+        attacked |= pawnAttacks[color][popLsb(b)];
+    for (Bitboard b = pieces[color][tKnight]; b;)
+        attacked |= knightAttacks[popLsb(b)];
+    for (Bitboard b = pieces[color][tBishop] | pieces[color][tQueen]; b;)
+        attacked |= bishopAttacks(popLsb(b), occupancy);
+    for (Bitboard b = pieces[color][tRook] | pieces[color][tQueen]; b;)
+        attacked |= rookAttacks(popLsb(b), occupancy);
+    return attacked;
+}
+
+void ChessBoard::updateAttacks() {
+    const Color us = activeColor, them = opposite(us);
+    const int king = lsb(pieces[us][tKing]);
+
+    checkingPieces = attackersTo(king, occupied) & colors[them];
+    // the king must not be able to step back along a slider's line
+    attackedSquares = attacks(them, occupied ^ pieces[us][tKing]);
+
+    // a lone piece of ours between the king and an enemy slider is pinned
+    pinnedPieces = 0;
+    const Bitboard straight = pieces[them][tRook] | pieces[them][tQueen];
+    const Bitboard diagonal = pieces[them][tBishop] | pieces[them][tQueen];
+    Bitboard snipers = (rookAttacks(king, 0) & straight) |
+                       (bishopAttacks(king, 0) & diagonal);
+    while (snipers) {
+        const Bitboard blockers = betweenBB[king][popLsb(snipers)] & occupied;
+        if (popCount(blockers) == 1) pinnedPieces |= blockers & colors[us];
+    }
+}
+
+bool ChessBoard::hasLegalMove() const {
+    const Color us = activeColor;
+    const int king = lsb(pieces[us][tKing]);
+    if (kingAttacks[king] & ~colors[us] & ~attackedSquares) return true;
+    // in double check only the king may move
+    if (popCount(checkingPieces) > 1) return false;
+
+    MoveList list;
+    generate<AllMoves>(list, us);
+    for (ChessMove move : list)
+        if (isLegal(move)) return true;
+    return false;
 }
 
-void ChessBoard::place(ChessPiece *piece) {
-    assert(piece);
-    movePiece(piece, piece->position());
+GameStatus ChessBoard::status() const {
+    if (hasLegalMove()) return checkingPieces ? Check : Playing;
+    return checkingPieces ? Checkmate : Stalemate;
+}
+
+void ChessBoard::place(Position position, Color color, Type type) {
+    assert(pieceCount < MAX_PIECES);
+    ChessPiece *piece = &arena[pieceCount++];
+    *piece = ChessPiece(position, color, type);
+    board[position.rank()][position.file()] = piece;
+    toggle(piece, square(position));
 }
 
 void ChessBoard::resetBoard() {
-    deletePieces();
+    clearPieces();
     initialiseBoard();
 }
 
-void ChessBoard::deletePieces() {
-    for (int rank = 0; rank < 8; rank++)
+// sets up the position described by a FEN string; a malformed string leaves
+// the starting position instead
+bool ChessBoard::setFen(std::string_view fen) {
+    PackedPosition packed;
+    if (packFen(fen, packed)) {
+        unpack(packed);
+        return true;
+    }
+
+    resetBoard();
+    return false;
+}
+
+void ChessBoard::pack(PackedPosition &packed) const {
+    for (Color color : {Black, White})
+        for (int type = tPawn; type <= tQueen; type++)
+            packed.pieces[color][type] = pieces[color][type];
+    packed.epSquare = int8_t(epSquare);
+    packed.castlingRights = uint8_t(castlingRights);
+    packed.activeColor = uint8_t(activeColor);
+    packed.halfmoveClock = uint8_t(std::min(halfmoveClock, 255));
+    packed.fullmoveNumber = uint16_t(fullmoveNumber);
+}
+
+void ChessBoard::unpack(const PackedPosition &packed) {
+    clearPieces();
+    for (Color color : {Black, White})
+        for (int type = tPawn; type <= tQueen; type++)
+            for (Bitboard b = packed.pieces[color][type]; b;)
+                place(positionOf(popLsb(b)), color, Type(type));
+
+    activeColor = Color(packed.activeColor);
+    castlingRights = packed.castlingRights;
+    epSquare = packed.epSquare;
+    halfmoveClock = packed.halfmoveClock;
+    fullmoveNumber = packed.fullmoveNumber;
+    // placing the pieces already keyed them
+    key ^= stateKey();
+    if (activeColor == Black) key ^= sideKey;
+    updateAttacks();
+}
+
+// the piece type of a FEN letter of either case, or -1; white's are the
+// upper case letters, which sort first
+static int pieceType(char symbol) {
+    switch (symbol | 0x20) {
+        case 'p':
+            return tPawn;
+        case 'r':
+            return tRook;
+        case 'n':
+            return tKnight;
+        case 'b':
+            return tBishop;
+        case 'k':
+            return tKing;
+        case 'q':
+            return tQueen;
+        default:
+            return -1;
+    }
+}
+
+// reads an unsigned decimal at fen[i], leaving i after it
+static int parseNumber(std::string_view fen, size_t &i, int fallback) {
+    if (i >= fen.size() || fen[i] < '0' || fen[i] > '9') return fallback;
+    int value = 0;
+    for (; i < fen.size() && fen[i] >= '0' && fen[i] <= '9'; i++)
+        value = value * 10 + fen[i] - '0';
+    return value;
+}
+
+static void skipSpaces(std::string_view fen, size_t &i) {
+    while (i < fen.size() && fen[i] == ' ') i++;
+}
+
+static Bitboard occupancyOf(const Bitboard (&pieces)[2][6]) {
+    Bitboard occupied = 0;
+    for (Color color : {Black, White})
+        for (int type = tPawn; type <= tQueen; type++)
+            occupied |= pieces[color][type];
+    return occupied;
+}
+
+// whether a piece of the given color attacks sq
+static bool isAttacked(const Bitboard (&pieces)[2][6], int sq, Color by) {
+    const Bitboard occupied = occupancyOf(pieces);
+    const Bitboard(&own)[6] = pieces[by];
+    return (pawnAttacks[by == White ? Black : White][sq] & own[tPawn]) ||
+           (knightAttacks[sq] & own[tKnight]) ||
+           (kingAttacks[sq] & own[tKing]) ||
+           (bishopAttacks(sq, occupied) & (own[tBishop] | own[tQueen])) ||
+           (rookAttacks(sq, occupied) & (own[tRook] | own[tQueen]));
+}
+
+bool packFen(std::string_view fen, PackedPosition &packed) {
+    Bitboard(&pieces)[2][6] = packed.pieces;
+    memset(pieces, 0, sizeof(packed.pieces));
+    const size_t n = fen.size();
+    size_t i = 0;
+    skipSpaces(fen, i);
+
+    int rank = 0, file = 0, count = 0;
+    for (; i < n && fen[i] != ' '; i++) {
+        const char c = fen[i];
+        if (c == '/') {
+            if (file != 8) return false;
+            rank++;
+            file = 0;
+        } else if (c >= '1' && c <= '8') {
+            file += c - '0';
+        } else {
+            const int type = pieceType(c);
+            if (rank > 7 || file > 7 || type < 0) return false;
+            if (count++ == MAX_PIECES) return false;
+            pieces[c < 'a' ? White : Black][type] |=
+                squareBB(square(rank, file));
+            file++;
+        }
+        if (file > 8) return false;
+    }
+    if (rank != 7 || file != 8) return false;
+    if (popCount(pieces[White][tKing]) != 1) return false;
+    if (popCount(pieces[Black][tKing]) != 1) return false;
+    // a pawn can neither stand on its own back rank nor stay on the last
+    if ((pieces[White][tPawn] | pieces[Black][tPawn]) &
+        (rankBB(0) | rankBB(7)))
+        return false;
+
+    skipSpaces(fen, i);
+    if (i >= n || (fen[i] != 'w' && fen[i] != 'b')) return false;
+    const Color activeColor = fen[i++] == 'w' ? White : Black;
+    packed.activeColor = uint8_t(activeColor);
+    // the side that just moved cannot have left its king in check, or the
+    // first move would take it
+    const Color them = activeColor == White ? Black : White;
+    if (isAttacked(pieces, lsb(pieces[them][tKing]), activeColor))
+        return false;
+
+    skipSpaces(fen, i);
+    int castlingRights = 0;
+    for (; i < n && fen[i] != ' '; i++) {
+        switch (fen[i]) {
+            case 'K':
+                castlingRights |= WhiteKingSide;
+                break;
+            case 'Q':
+                castlingRights |= WhiteQueenSide;
+                break;
+            case 'k':
+                castlingRights |= BlackKingSide;
+                break;
+            case 'q':
+                castlingRights |= BlackQueenSide;
+                break;
+            case '-':
+                break;
+            default:
+                return false;
+        }
+    }
+
+    // a right whose king or rook has left its square cannot be used
+    const Bitboard whiteRooks = pieces[White][tRook];
+    const Bitboard blackRooks = pieces[Black][tRook];
+    if (!(pieces[White][tKing] & squareBB(60)))
+        castlingRights &= ~(WhiteKingSide | WhiteQueenSide);
+    if (!(pieces[Black][tKing] & squareBB(4)))
+        castlingRights &= ~(BlackKingSide | BlackQueenSide);
+    if (!(whiteRooks & squareBB(63))) castlingRights &= ~WhiteKingSide;
+    if (!(whiteRooks & squareBB(56))) castlingRights &= ~WhiteQueenSide;
+    if (!(blackRooks & squareBB(7))) castlingRights &= ~BlackKingSide;
+    if (!(blackRooks & squareBB(0))) castlingRights &= ~BlackQueenSide;
+    packed.castlingRights = uint8_t(castlingRights);
+
+    skipSpaces(fen, i);
+    packed.epSquare = -1;
+    if (i + 1 < n && fen[i] >= 'a' && fen[i] <= 'h' &&
+        fen[i + 1] == (activeColor == White ? '6' : '3')) {
+        packed.epSquare = int8_t(square('8' - fen[i + 1], fen[i] - 'a'));
+        i += 2;
+        // without the pawn that just passed it the square means nothing,
+        // and taking on it would remove a piece that is not there
+        const int ep = packed.epSquare;
+        const int pawn = ep + (activeColor == White ? 8 : -8);
+        const int origin = ep + (activeColor == White ? -8 : 8);
+        const Bitboard occupied = occupancyOf(pieces);
+        if (!(pieces[them][tPawn] & squareBB(pawn)) ||
+            (occupied & (squareBB(ep) | squareBB(origin))))
+            packed.epSquare = -1;
+    } else if (i < n && fen[i] == '-') {
+        i++;
+    } else if (i < n) {
+        return false;
+    }
+
+    // the move counters are optional, as in EPD
+    skipSpaces(fen, i);
+    packed.halfmoveClock = uint8_t(std::min(parseNumber(fen, i, 0), 255));
+    skipSpaces(fen, i);
+    packed.fullmoveNumber =
+        uint16_t(std::max(1, std::min(parseNumber(fen, i, 1), 65535)));
+    return true;
+}
+
+// writes value in decimal at out and returns the end
+static char *writeNumber(char *out, int value) {
+    char digits[12];
+    int count = 0;
+    do {
+        digits[count++] = '0' + value % 10;
+        value /= 10;
+    } while (value);
+    while (count) *out++ = digits[--count];
+    return out;
+}
+
+char *ChessBoard::toFen(char *buf) const {
+    static const char symbols[] = "prnbkq";
+    char *out = buf;
+
+    for (int rank = 0; rank < 8; rank++) {
+        int empty = 0;
         for (int file = 0; file < 8; file++) {
-            ChessPiece *piece = getPiece(Position(rank, file));
-            if (!piece) continue;
-            delete piece;
-            movePiece(NULL, Position(rank, file));
+            const ChessPiece *piece = board[rank][file];
+            if (!piece) {
+                empty++;
+                continue;
+            }
+            if (empty) *out++ = '0' + empty;
+            empty = 0;
+            const char symbol = symbols[piece->type()];
+            *out++ = piece->color() == White ? symbol - 'a' + 'A' : symbol;
         }
+        if (empty) *out++ = '0' + empty;
+        if (rank < 7) *out++ = '/';
+    }
+
+    *out++ = ' ';
+    *out++ = activeColor == White ? 'w' : 'b';
+
+    *out++ = ' ';
+    if (castlingRights & WhiteKingSide) *out++ = 'K';
+    if (castlingRights & WhiteQueenSide) *out++ = 'Q';
+    if (castlingRights & BlackKingSide) *out++ = 'k';
+    if (castlingRights & BlackQueenSide) *out++ = 'q';
+    if (!castlingRights) *out++ = '-';
+
+    *out++ = ' ';
+    if (epSquare >= 0) {
+        *out++ = 'a' + fileOf(epSquare);
+        *out++ = '8' - rankOf(epSquare);
+    } else {
+        *out++ = '-';
+    }
+
+    *out++ = ' ';
+    out = writeNumber(out, halfmoveClock);
+    *out++ = ' ';
+    out = writeNumber(out, fullmoveNumber);
+    *out = '\0';
+    return buf;
+}
+
+void ChessBoard::clearPieces() {
+    for (int i = 0; i < 8; i++)
+        for (int j = 0; j < 8; j++) board[i][j] = NULL;
+    for (Color color : {Black, White}) {
+        colors[color] = 0;
+        for (int type = tPawn; type <= tQueen; type++)
+            pieces[color][type] = 0;
+    }
+    occupied = 0;
+    key = 0;
+    pawnKey = 0;
+    psq = 0;
+    phase = 0;
+    nnueActive = false;
+    pieceCount = 0;
+    ply = 0;
+}
+
+// pointers into the other board's arena become the same slots in ours
+void ChessBoard::copyPieces(const ChessBoard &other) {
+    pieceCount = other.pieceCount;
+    std::copy(other.arena, other.arena + pieceCount, arena);
+
+    for (int i = 0; i < 8; i++)
+        for (int j = 0; j < 8; j++) {
+            const ChessPiece *piece = other.board[i][j];
+            board[i][j] = piece ? arena + (piece - other.arena) : NULL;
+        }
+
+    std::copy(other.history, other.history + other.ply, history);
+    for (int i = 0; i < other.ply; i++)
+        if (history[i].captured)
+            history[i].captured = arena + (history[i].captured - other.arena);
+
+    for (Color color : {Black, White}) {
+        colors[color] = other.colors[color];
+        for (int type = tPawn; type <= tQueen; type++)
+            pieces[color][type] = other.pieces[color][type];
+    }
+
+    activeColor = other.activeColor;
+    occupied = other.occupied;
+    castlingRights = other.castlingRights;
+    epSquare = other.epSquare;
+    halfmoveClock = other.halfmoveClock;
+    fullmoveNumber = other.fullmoveNumber;
+    key = other.key;
+    pawnKey = other.pawnKey;
+    psq = other.psq;
+    phase = other.phase;
+    nnueActive = other.nnueActive;
+    if (nnueActive) nnue = other.nnue;
+    checkingPieces = other.checkingPieces;
+    pinnedPieces = other.pinnedPieces;
+    attackedSquares = other.attackedSquares;
+    output = other.output;
+    style = other.style;
+    ply = other.ply;
 }
 
 void ChessBoard::initialiseBoard() {
-    place(new Rook("A8", Black));
-    place(new Rook("A1", White));
-    place(new Rook("H8", Black));
-    place(new Rook("H1", White));
-    place(new Knight("B8", Black));
-    place(new Knight("B1", White));
-    place(new Knight("G8", Black));
-    place(new Knight("G1", White));
-    place(new Bishop("C8", Black));
-    place(new Bishop("C1", White));
-    place(new Bishop("F8", Black));
-    place(new Bishop("F1", White));
-    place(new Queen("D8", Black));
-    place(new Queen("D1", White));
-    place(new King("E8", Black));
-    place(new King("E1", White));
-
-    for (int i = 0; i < 8; i++) {
-        char pos[2][3] = {{static_cast<char>('A' + i), '2', '\0'},
-                          {static_cast<char>('A' + i), '7', '\0'}};
-
-        place(new Pawn(pos[0], White));
-        place(new Pawn(pos[1], Black));
-    }
-
-    king[Black] = getPiece(Position("E8"));
-    king[White] = getPiece(Position("E1"));
+    static const Type backRank[8] = {tRook, tKnight, tBishop, tQueen,
+                                     tKing, tBishop, tKnight, tRook};
+    for (int file = 0; file < 8; file++) {
+        place(Position(0, file), Black, backRank[file]);
+        place(Position(7, file), White, backRank[file]);
+        place(Position(1, file), Black, tPawn);
+        place(Position(6, file), White, tPawn);
+    }
 
     activeColor = White;
+    castlingRights = WhiteKingSide | WhiteQueenSide | BlackKingSide |
+                     BlackQueenSide;
+    epSquare = -1;
+    halfmoveClock = 0;
+    fullmoveNumber = 1;
+    key = computeKey();
+    updateAttacks();
 }
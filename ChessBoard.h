@@ -1,37 +1,225 @@
 #ifndef BOARD_H
 #define BOARD_H
 
+#include <iosfwd>
+#include <string>
+#include <string_view>
+
+#include "Bitboard.h"
+#include "ChessMove.h"
+#include "ChessPiece.h"
+#include "Nnue.h"
 #include "Position.h"
+#include "Psqt.h"
+
+enum CastlingRight {
+    WhiteKingSide = 1,
+    WhiteQueenSide = 2,
+    BlackKingSide = 4,
+    BlackQueenSide = 8
+};
+
+enum GenType { Captures, Quiets, AllMoves };
+
+// the state of the game for the side to move
+enum GameStatus { Playing, Check, Checkmate, Stalemate };
+
+// how a position is drawn: letter pairs ("WQ"), chess glyphs, or FEN
+enum RenderStyle { Ascii, Unicode, Fen };
 
-class ChessPiece;
-enum Color : int;
+// everything makeMove changes that the move itself cannot restore; plain
+// data, so that the history costs nothing to construct with its board
+struct UndoInfo {
+    uint16_t move;
+    ChessPiece *captured;
+    int castlingRights;
+    int epSquare;
+    int halfmoveClock;
+    uint64_t key;
+    Bitboard checkers, pinned, threats;
+};
+
+// a position in a little over 100 bytes: enough to go on playing from,
+// but without the history, so repetitions before it are forgotten
+struct PackedPosition {
+    Bitboard pieces[2][6];
+    int8_t epSquare;
+    uint8_t castlingRights;
+    uint8_t activeColor;
+    uint8_t halfmoveClock;
+    uint16_t fullmoveNumber;
+};
+
+const int MAX_GAME_PLY = 1024;
+// a legal position never has more pieces than the initial one
+const int MAX_PIECES = 32;
+// longest FEN toFen can write, with the terminating NUL
+const int MAX_FEN = 96;
+// longest drawing render can write, with the terminating NUL
+const int MAX_RENDER = 512;
 
 class ChessBoard {
    public:
     Color activeColor;
 
     ChessBoard();
+    ChessBoard(const ChessBoard &);
+    ChessBoard &operator=(const ChessBoard &);
+    ~ChessBoard();
     void submitMove(const char *, const char *);
     void submitMove(const char *);
     ChessPiece *getPiece(Position) const;
+    // the piece on a square number, or NULL
+    ChessPiece *pieceAt(int) const;
+    Bitboard occupancy() const;
+    Bitboard occupancy(Color) const;
+    Bitboard occupancy(Color, Type) const;
+    int halfmoves() const;
+    int fullmoves() const;
+    // whether either side still has a castling right
+    bool canCastle() const;
     bool checkMove(Position, Position, Color) const;
     bool isMarkedBy(Position, Color) const;
     bool isInCheck(Color) const;
     bool isInStalemate(Color) const;
     bool isInCheckmate(Color) const;
+
+    // worked out once per move for the side to move: the pieces giving
+    // check, its own pieces pinned to its king, and every square the
+    // opponent attacks, seen through the king
+    Bitboard checkers() const;
+    Bitboard pinned() const;
+    Bitboard threats() const;
+    // every square the color attacks, given the occupancy
+    Bitboard attacks(Color, Bitboard occupancy) const;
+    // whether the side to move is in check, mated, stalemated or neither;
+    // usually settled by the king's escape squares alone
+    GameStatus status() const;
     void resetBoard();
-    void printBoard();
+    // loads a FEN, or the first four fields of an EPD line, in one pass; a
+    // malformed string leaves the starting position and returns false
+    bool setFen(std::string_view);
+    // writes the position as a NUL-terminated FEN into buf, which must
+    // hold MAX_FEN characters, and returns buf
+    char *toFen(char *buf) const;
+    // stores the position compactly, and sets the board up from such a
+    // store as a new game
+    void pack(PackedPosition &) const;
+    void unpack(const PackedPosition &);
+
+    // pseudo-legal moves for the side to move; captures are every capture
+    // and promotion, quiets are everything else
+    void generateMoves(MoveList &) const;
+    void generateCaptures(MoveList &) const;
+    void generateQuiets(MoveList &) const;
+    void generateLegalMoves(MoveList &) const;
+    bool isLegal(ChessMove) const;
+    // whether the generator could have produced the move here, for moves
+    // remembered from elsewhere in the tree such as killers
+    bool isPseudoLegal(ChessMove) const;
+    // static exchange evaluation: whether the move wins at least threshold
+    // centipawns once every capture and recapture on its destination square
+    // has been played out, least valuable attacker first. Pins are ignored;
+    // castling, en passant and promotions count as winning nothing.
+    bool see(ChessMove, int threshold = 0) const;
+    ChessMove findMove(Position, Position) const;
+
+    // plays a legal move; every move made can be taken back in turn
+    void makeMove(ChessMove);
+    void unmakeMove();
+    // passes the turn without moving, never while in check
+    void makeNullMove();
+    void unmakeNullMove();
+    // the move that led here, or a null move at the root
+    ChessMove lastMove() const;
+
+    // material and piece-square score from white's point of view, and the
+    // game phase (MAX_PHASE with every piece on), both maintained
+    // incrementally
+    Score psqScore() const;
+    int gamePhase() const;
+    Score computePsq() const;
+
+    // rebuilds the network's accumulator and keeps it up to date from then
+    // on; accumulator() is NULL while none is being kept, or no network is
+    // enabled
+    void refreshAccumulator();
+    const Accumulator *accumulator() const;
+    bool accumulatorMatches() const;
+
+    // Zobrist key of the position, maintained incrementally
+    uint64_t hash() const;
+    uint64_t computeKey() const;
+    // the same for the pawns alone, keying the pawn structure
+    uint64_t pawnHash() const;
+    uint64_t computePawnKey() const;
+    // whether the position occurred before since the last irreversible move
+    bool isRepetition() const;
+
+    // draws the position without allocating: into buf, which must hold
+    // MAX_RENDER characters, returning the length; or into a string whose
+    // capacity is reused from call to call
+    int render(char *buf, RenderStyle = Ascii) const;
+    void render(std::string &, RenderStyle = Ascii) const;
+
+    // where submitMove reports moves, results and the board, and in which
+    // style; NULL makes it quiet. Defaults to std::cout and Ascii.
+    void setOutput(std::ostream *, RenderStyle = Ascii);
+    void printBoard() const;
     static Color opposite(Color);
 
    private:
-    mutable ChessPiece *board[8][8];
-    ChessPiece *king[2];
+    // every piece on the board or captured in the history lives in the
+    // arena, so setting up or copying a board never touches the heap
+    ChessPiece arena[MAX_PIECES];
+    int pieceCount;
+    ChessPiece *board[8][8];
 
-    ChessPiece *move(Position, Position) const;
-    void movePiece(ChessPiece *, Position) const;
-    void place(ChessPiece *);
+    std::ostream *output;
+    RenderStyle style;
+
+    // bitboard mirror of board, kept in step by movePiece
+    Bitboard pieces[2][6];
+    Bitboard colors[2];
+    Bitboard occupied;
+
+    int castlingRights;
+    int epSquare;
+    int halfmoveClock;
+    int fullmoveNumber;
+    uint64_t key;
+    uint64_t pawnKey;
+    Score psq;
+    int phase;
+    // only kept once refreshAccumulator is called; loading a position or
+    // copying a board without one turns it off again
+    Accumulator nnue;
+    bool nnueActive;
+
+    Bitboard checkingPieces;
+    Bitboard pinnedPieces;
+    Bitboard attackedSquares;
+
+    UndoInfo history[MAX_GAME_PLY];
+    int ply;
+
+    void movePiece(ChessPiece *, Position);
+    void toggle(ChessPiece *, int);
+    Bitboard attackersTo(int, Bitboard) const;
+    uint64_t stateKey() const;
+    void updateAttacks();
+    bool hasLegalMove() const;
+    template <GenType>
+    void generate(MoveList &, Color) const;
+    void place(Position, Color, Type);
     void initialiseBoard();
-    void deletePieces();
+    void clearPieces();
+    void copyPieces(const ChessBoard &);
 };
 
+// reads a FEN, or the first four fields of an EPD line, straight into a
+// packed position, accepting just what setFen does; for loading positions
+// in bulk without setting up a board for each
+bool packFen(std::string_view, PackedPosition &);
+
 #endif
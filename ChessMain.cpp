@@ -1,15 +1,29 @@
+#include <cstring>
 #include <iostream>
 
+#include "Benchmark.h"
+#include "Bitboard.h"
+#include "Book.h"
 #include "ChessBoard.h"
+#include "Engine.h"
+#include "Epd.h"
+#include "Nnue.h"
+#include "Perft.h"
+#include "Pgn.h"
+#include "Server.h"
+#include "Tablebase.h"
+#include "Uci.h"
 
 using std::cout;
 
-int main() {
+// plays the sample games, reporting moves to os (NULL for none) in style
+static int runDemo(std::ostream *os, RenderStyle style) {
     cout << "========================\n";
     cout << "Testing the Chess Engine\n";
     cout << "========================\n\n";
 
     ChessBoard cb;
+    cb.setOutput(os, style);
     cout << '\n';
 
     cb.submitMove("D7", "D6");
@@ -111,3 +125,49 @@ int main() {
 
     return 0;
 }
+
+int main(int argc, char **argv) {
+    if (argc > 1 && !strcmp(argv[1], "tables")) {
+        reportAttackTables(cout);
+        return 0;
+    }
+
+    if (argc > 1 && !strcmp(argv[1], "perft"))
+        return perftCommand(argc - 2, argv + 2);
+
+    if (argc > 1 && !strcmp(argv[1], "search"))
+        return searchCommand(argc - 2, argv + 2);
+
+    if (argc > 1 && !strcmp(argv[1], "uci")) return uciCommand();
+
+    if (argc > 1 && !strcmp(argv[1], "epd"))
+        return epdCommand(argc - 2, argv + 2);
+
+    if (argc > 1 && !strcmp(argv[1], "bench"))
+        return benchCommand(argc - 2, argv + 2);
+
+    if (argc > 1 && !strcmp(argv[1], "match"))
+        return matchCommand(argc - 2, argv + 2);
+
+    if (argc > 1 && !strcmp(argv[1], "pgn"))
+        return pgnCommand(argc - 2, argv + 2);
+
+    if (argc > 1 && !strcmp(argv[1], "book"))
+        return bookCommand(argc - 2, argv + 2);
+
+    if (argc > 1 && !strcmp(argv[1], "tb"))
+        return tablebaseCommand(argc - 2, argv + 2);
+
+    if (argc > 1 && !strcmp(argv[1], "server"))
+        return serverCommand(argc - 2, argv + 2);
+
+    if (argc > 1 && !strcmp(argv[1], "nnue"))
+        return nnueCommand(argc - 2, argv + 2);
+
+    if (argc > 1 && !strcmp(argv[1], "--unicode"))
+        return runDemo(&cout, Unicode);
+    if (argc > 1 && !strcmp(argv[1], "--fen")) return runDemo(&cout, Fen);
+    if (argc > 1 && !strcmp(argv[1], "--quiet")) return runDemo(NULL, Ascii);
+
+    return runDemo(&cout, Ascii);
+}
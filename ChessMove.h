@@ -0,0 +1,88 @@
+#ifndef MOVE_H
+#define MOVE_H
+
+#include <cstdint>
+
+// what kind of move a ChessMove is; bit 2 marks captures and bit 3 marks
+// promotions, whose low two bits select the promoted piece
+enum MoveFlag {
+    Quiet,
+    DoublePush,
+    KingCastle,
+    QueenCastle,
+    Capture,
+    EnPassant,
+    PromoteKnight = 8,
+    PromoteBishop,
+    PromoteRook,
+    PromoteQueen,
+    CapturePromoteKnight,
+    CapturePromoteBishop,
+    CapturePromoteRook,
+    CapturePromoteQueen
+};
+
+// a move packed into 16 bits: origin square, destination square and flag
+class ChessMove {
+   private:
+    uint16_t data;
+
+   public:
+    ChessMove() : data(0) {}
+    ChessMove(int from, int to, int flag)
+        : data(uint16_t(from | (to << 6) | (flag << 12))) {}
+    explicit ChessMove(uint16_t bits) : data(bits) {}
+
+    int from() const { return data & 63; }
+    int to() const { return (data >> 6) & 63; }
+    int flag() const { return data >> 12; }
+    bool isCapture() const { return flag() & Capture; }
+    bool isPromotion() const { return flag() & PromoteKnight; }
+    bool isNull() const { return data == 0; }
+    bool isCastle() const {
+        return flag() == KingCastle || flag() == QueenCastle;
+    }
+    uint16_t raw() const { return data; }
+
+    // writes the move in coordinate notation, e.g. "e2e4" or "e7e8q"
+    const char *str(char buf[6]) const {
+        buf[0] = 'a' + (from() & 7);
+        buf[1] = '8' - (from() >> 3);
+        buf[2] = 'a' + (to() & 7);
+        buf[3] = '8' - (to() >> 3);
+        buf[4] = isPromotion() ? "nbrq"[flag() & 3] : '\0';
+        buf[5] = '\0';
+        return buf;
+    }
+
+    bool operator==(const ChessMove &move) const { return data == move.data; }
+    bool operator!=(const ChessMove &move) const { return data != move.data; }
+};
+
+// no position has more than 218 legal moves
+const int MAX_MOVES = 256;
+
+// fixed-capacity list filled by the move generator, meant to live on the
+// stack
+class MoveList {
+   private:
+    ChessMove moves[MAX_MOVES];
+    int count;
+
+   public:
+    MoveList() : count(0) {}
+
+    void push(ChessMove move) { moves[count++] = move; }
+    void clear() { count = 0; }
+    int size() const { return count; }
+    bool empty() const { return count == 0; }
+
+    ChessMove &operator[](int i) { return moves[i]; }
+    const ChessMove &operator[](int i) const { return moves[i]; }
+    ChessMove *begin() { return moves; }
+    ChessMove *end() { return moves + count; }
+    const ChessMove *begin() const { return moves; }
+    const ChessMove *end() const { return moves + count; }
+};
+
+#endif
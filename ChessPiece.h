@@ -8,8 +8,10 @@
 class ChessBoard;
 
 enum Color : int { Black, White };
-enum Type { tPawn, tRook, tKnight, tBishop, tKing, tQueen };
+enum Type : int { tPawn, tRook, tKnight, tBishop, tKing, tQueen };
 
+// a plain value: no virtual functions, so pieces can be copied and
+// stored inline in their board
 class ChessPiece {
     friend std::ostream& operator<<(std::ostream& os, ChessPiece* p);
     friend class ChessBoard;
@@ -21,65 +23,28 @@ class ChessPiece {
     int mvCnt;
 
    public:
-    // initialise a piece by position
-    ChessPiece(const char*, Color);
-    virtual ~ChessPiece() = default;
+    ChessPiece();
+    ChessPiece(Position, Color, Type);
     Color color() const;
     Position position() const;
     Type type() const;
     void setType(Type);
-    const char* str() const;
+    // writes the two-letter name ("WQ") into buf and returns buf
+    char* str(char buf[3]) const;
     int moveCount() const;
     void setPosition(Position);
     void incrementMoveCount();
     void decrementMoveCount();
-    void reportInvalidMove(Position);
-
-   protected:
-    virtual bool verifyMove(const ChessBoard*, Position) const = 0;
-    virtual bool canMove(const ChessBoard*) const = 0;
-};
-
-class Rook : public ChessPiece {
-   public:
-    Rook(const char*, Color);
-    bool verifyMove(const ChessBoard*, Position) const override;
-    bool canMove(const ChessBoard*) const override;
-};
-
-class Knight : public ChessPiece {
-   public:
-    Knight(const char*, Color);
-    bool verifyMove(const ChessBoard*, Position) const override;
-    bool canMove(const ChessBoard*) const override;
-};
-
-class Bishop : public ChessPiece {
-   public:
-    Bishop(const char*, Color);
-    bool verifyMove(const ChessBoard*, Position) const override;
-    bool canMove(const ChessBoard*) const override;
+    void reportInvalidMove(Position, std::ostream&) const;
 };
 
-class Queen : public ChessPiece {
-   public:
-    Queen(const char*, Color);
-    bool verifyMove(const ChessBoard*, Position) const override;
-    bool canMove(const ChessBoard*) const override;
-};
-
-class King : public ChessPiece {
-   public:
-    King(const char*, Color);
-    bool verifyMove(const ChessBoard*, Position) const override;
-    bool canMove(const ChessBoard*) const override;
-};
-
-class Pawn : public ChessPiece {
-   public:
-    Pawn(const char*, Color);
-    bool verifyMove(const ChessBoard*, Position) const override;
-    bool canMove(const ChessBoard*) const override;
-};
+inline Color ChessPiece::color() const { return col; }
+inline Position ChessPiece::position() const { return pos; }
+inline Type ChessPiece::type() const { return typ; }
+inline void ChessPiece::setType(Type t) { typ = t; }
+inline int ChessPiece::moveCount() const { return mvCnt; }
+inline void ChessPiece::incrementMoveCount() { mvCnt++; }
+inline void ChessPiece::decrementMoveCount() { mvCnt--; }
+inline void ChessPiece::setPosition(Position position) { pos = position; }
 
 #endif
@@ -0,0 +1,778 @@
+#include "Engine.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+
+#include "ChessPiece.h"
+#include "Evaluation.h"
+#include "Nnue.h"
+#include "Tablebase.h"
+
+// how often, in nodes, the clock is read
+const int CHECK_INTERVAL = 1024;
+// time kept in hand against communication and scheduling delays
+const int MOVE_OVERHEAD = 20;
+const int ASPIRATION_DEPTH = 4;
+const int ASPIRATION_WINDOW = 25;
+// info lines are written as they come but flushed no more often than this
+const int FLUSH_INTERVAL = 100;
+
+// helper i skips iteration d when ((d + phase) / size) is odd, using entry
+// (i - 1) % 20, so that helpers are spread over neighbouring depths
+const int SKIP_SIZE[20] = {1, 1, 2, 2, 2, 2, 3, 3, 3, 3,
+                           3, 3, 4, 4, 4, 4, 4, 4, 4, 4};
+const int SKIP_PHASE[20] = {0, 1, 0, 1, 2, 3, 0, 1, 2, 3,
+                            4, 5, 0, 1, 2, 3, 4, 5, 6, 7};
+
+// selective search: null moves only from this depth, futility and reverse
+// futility below these, razoring below that, and late move reductions from
+// this depth and move number
+const int NULL_MOVE_DEPTH = 3;
+const int FUTILITY_DEPTH = 4;
+const int STATIC_NULL_DEPTH = 7;
+const int RAZOR_DEPTH = 3;
+const int LMR_DEPTH = 3;
+const int LMR_MOVES = 4;
+
+// what an endgame table win scores: above any evaluation, below any mate
+const int TB_WIN_SCORE = MATE_BOUND - MAX_PLY;
+// how much deeper than the node a table result is stored as being
+const int TB_DEPTH_BONUS = 6;
+
+// late move reductions in plies, by depth and move number
+static int reductions[64][64];
+
+static bool buildReductions() {
+    for (int depth = 1; depth < 64; depth++)
+        for (int moves = 1; moves < 64; moves++)
+            reductions[depth][moves] =
+                int(0.75 + std::log(depth) * std::log(moves) / 2.25);
+    return true;
+}
+
+static int reduction(int depth, int moves) {
+    return reductions[std::min(depth, 63)][std::min(moves, 63)];
+}
+
+SearchOptions::SearchOptions()
+    : quiescence(true),
+      nullMove(true),
+      nullMoveReduction(2),
+      lateMoveReductions(true),
+      futility(true),
+      futilityMargin(100),
+      razoring(true),
+      razorMargin(300),
+      checkExtensions(true),
+      probeLimit(TB_PIECES) {}
+
+SearchOptions SearchOptions::plain() {
+    SearchOptions options;
+    options.quiescence = options.nullMove = false;
+    options.lateMoveReductions = options.futility = false;
+    options.razoring = options.checkExtensions = false;
+    return options;
+}
+
+bool disableFeatures(SearchOptions &options, const char *list) {
+    for (;;) {
+        const char *comma = strchr(list, ',');
+        const std::string name(list, comma ? comma - list : strlen(list));
+        if (name == "all")
+            options = SearchOptions::plain();
+        else if (name == "qsearch")
+            options.quiescence = false;
+        else if (name == "null")
+            options.nullMove = false;
+        else if (name == "lmr")
+            options.lateMoveReductions = false;
+        else if (name == "futility")
+            options.futility = false;
+        else if (name == "razoring")
+            options.razoring = false;
+        else if (name == "extensions")
+            options.checkExtensions = false;
+        else
+            return false;
+        if (!comma) return true;
+        list = comma + 1;
+    }
+}
+
+SearchLimits::SearchLimits()
+    : depth(0),
+      nodes(0),
+      movetime(0),
+      movestogo(0),
+      infinite(false),
+      ponder(false) {
+    time[Black] = time[White] = 0;
+    increment[Black] = increment[White] = 0;
+}
+
+SearchThread::SearchThread(int index)
+    : id(index),
+      nodes(0),
+      rootDepth(0),
+      completedDepth(0),
+      bestScore(0),
+      bestLength(0),
+      cutoffs(0),
+      firstMoveCutoffs(0),
+      tbProbes(0),
+      tbHits(0) {
+    clearHistory();
+}
+
+void SearchThread::clearHistory() {
+    std::fill(&counterMoves[0][0], &counterMoves[0][0] + 64 * 64, ChessMove());
+    std::fill(&history[0][0][0], &history[0][0][0] + 2 * 64 * 64, 0);
+}
+
+Engine::Engine()
+    : optimumTime(0),
+      maximumTime(0),
+      stopped(false),
+      pondering(false),
+      bestScore(0),
+      bestDepth(0),
+      rootInTables(false),
+      out(NULL),
+      outputLock(NULL) {
+    static const bool built = buildReductions();
+    (void)built;
+    setThreads(1);
+}
+
+void Engine::setOutput(std::ostream *os, std::mutex *lock) {
+    out = os;
+    outputLock = lock;
+}
+
+void Engine::stop() { stopped = true; }
+void Engine::ponderhit() { pondering = false; }
+ChessMove Engine::ponderMove() const { return expectedReply; }
+int Engine::score() const { return bestScore; }
+int Engine::depth() const { return bestDepth; }
+
+bool Engine::setHashSize(size_t megabytes) {
+    return table.resize(megabytes, threadCount());
+}
+
+size_t Engine::hashSize() const { return table.megabytes(); }
+
+void Engine::clearHash() {
+    table.clear(threadCount());
+    for (std::unique_ptr<SearchThread> &thread : threads) {
+        thread->pawns.clear();
+        thread->clearHistory();
+    }
+}
+
+void Engine::setThreads(int count) {
+    threads.clear();
+    for (int i = 0; i < std::max(1, count); i++)
+        threads.push_back(std::unique_ptr<SearchThread>(new SearchThread(i)));
+}
+
+int Engine::threadCount() const { return int(threads.size()); }
+
+void Engine::setOptions(const SearchOptions &options) { settings = options; }
+const SearchOptions &Engine::options() const { return settings; }
+
+uint64_t Engine::nodes() const {
+    uint64_t total = 0;
+    for (const std::unique_ptr<SearchThread> &thread : threads)
+        total += thread->nodes.load(std::memory_order_relaxed);
+    return total;
+}
+
+int Engine::pawnHits() const {
+    uint64_t probes = 0, hits = 0;
+    for (const std::unique_ptr<SearchThread> &thread : threads) {
+        probes += thread->pawns.probes();
+        hits += thread->pawns.hits();
+    }
+    return probes ? int(hits * 1000 / probes) : 0;
+}
+
+int Engine::firstMoveCutoffs() const {
+    uint64_t cutoffs = 0, first = 0;
+    for (const std::unique_ptr<SearchThread> &thread : threads) {
+        cutoffs += thread->cutoffs;
+        first += thread->firstMoveCutoffs;
+    }
+    return cutoffs ? int(first * 1000 / cutoffs) : 0;
+}
+
+uint64_t Engine::tablebaseProbes() const {
+    uint64_t total = 0;
+    for (const std::unique_ptr<SearchThread> &thread : threads)
+        total += thread->tbProbes.load(std::memory_order_relaxed);
+    return total;
+}
+
+uint64_t Engine::tablebaseHits() const {
+    uint64_t total = 0;
+    for (const std::unique_ptr<SearchThread> &thread : threads)
+        total += thread->tbHits.load(std::memory_order_relaxed);
+    return total;
+}
+
+double Engine::branchingFactor() const {
+    const SearchThread &main = *threads[0];
+    const int depth = main.completedDepth;
+    if (depth < 2 || !main.iterationNodes[depth - 1]) return 0;
+    return double(main.iterationNodes[depth]) / main.iterationNodes[depth - 1];
+}
+
+int Engine::elapsed() const {
+    return int(std::chrono::duration_cast<std::chrono::milliseconds>(
+                   Clock::now() - start)
+                   .count());
+}
+
+// optimumTime is what we aim to spend, maximumTime is where a running
+// iteration is abandoned
+void Engine::allocateTime(int color) {
+    optimumTime = maximumTime = 0;
+
+    if (limits.movetime) {
+        optimumTime = std::max(1, limits.movetime - MOVE_OVERHEAD);
+        maximumTime = optimumTime;
+        return;
+    }
+
+    if (!limits.time[color]) return;
+
+    const int left = std::max(1, limits.time[color] - MOVE_OVERHEAD);
+    const int movesLeft = limits.movestogo ? limits.movestogo : 30;
+    optimumTime = left / movesLeft + limits.increment[color] * 3 / 4;
+    optimumTime = std::min(optimumTime, left / 2);
+    maximumTime = std::min(optimumTime * 4, left * 3 / 4);
+    optimumTime = std::max(1, optimumTime);
+    maximumTime = std::max(optimumTime, maximumTime);
+}
+
+// only the main thread watches the clock and the node budget
+void Engine::checkLimits(SearchThread &thread) {
+    // the first iteration always completes so there is a move to play
+    if (thread.id != 0 || thread.rootDepth <= 1 || limits.infinite ||
+        pondering)
+        return;
+
+    const uint64_t count = thread.nodes.load(std::memory_order_relaxed);
+    if (count % CHECK_INTERVAL) return;
+
+    if (limits.nodes && nodes() >= limits.nodes) stopped = true;
+    if (maximumTime && elapsed() >= maximumTime) stopped = true;
+}
+
+// mate scores are stored relative to the node rather than the root, so
+// they stay correct when the position is reached at another ply
+static int scoreToTable(int score, int ply) {
+    if (score >= MATE_BOUND) return score + ply;
+    if (score <= -MATE_BOUND) return score - ply;
+    return score;
+}
+
+static int scoreFromTable(int score, int ply) {
+    if (score >= MATE_BOUND) return score - ply;
+    if (score <= -MATE_BOUND) return score + ply;
+    return score;
+}
+
+// captures and promotions only, until the position is quiet; the side to
+// move may stand pat on the static evaluation unless in check
+int Engine::quiesce(SearchThread &thread, int ply, int alpha, int beta) {
+    ChessBoard &board = thread.board;
+    thread.pvLength[ply] = ply;
+    thread.nodes.store(thread.nodes.load(std::memory_order_relaxed) + 1,
+                       std::memory_order_relaxed);
+    checkLimits(thread);
+    if (stopped) return 0;
+
+    const bool inCheck = board.checkers();
+    if (ply >= MAX_PLY - 1) return evaluate(board, &thread.pawns);
+
+    int best = -INFINITE_SCORE;
+    if (!inCheck) {
+        best = evaluate(board, &thread.pawns);
+        if (best >= beta) return best;
+        alpha = std::max(alpha, best);
+    }
+
+    // in check every evasion is searched, otherwise the captures that do
+    // not lose material
+    MovePicker picker =
+        inCheck ? MovePicker(board, ChessMove(), thread.killers[ply],
+                             ChessMove(), thread.history[board.activeColor])
+                : MovePicker(board);
+
+    int legal = 0;
+    for (ChessMove move; !(move = picker.next()).isNull();) {
+        if (!board.isLegal(move)) continue;
+        legal++;
+
+        board.makeMove(move);
+        const int score = -quiesce(thread, ply + 1, -beta, -alpha);
+        board.unmakeMove();
+        if (stopped) return 0;
+
+        if (score <= best) continue;
+        best = score;
+        if (score <= alpha) continue;
+        alpha = score;
+        if (alpha >= beta) break;
+    }
+
+    if (inCheck && !legal) return -MATE_SCORE + ply;
+    return best;
+}
+
+int Engine::negamax(SearchThread &thread, int depth, int ply, int alpha,
+                    int beta, bool allowNull) {
+    ChessBoard &board = thread.board;
+    const bool pvNode = beta - alpha > 1;
+    const bool inCheck = board.checkers();
+    if (inCheck && settings.checkExtensions) depth++;
+    if (depth <= 0 && settings.quiescence)
+        return quiesce(thread, ply, alpha, beta);
+
+    thread.pvLength[ply] = ply;
+    thread.nodes.store(thread.nodes.load(std::memory_order_relaxed) + 1,
+                       std::memory_order_relaxed);
+    checkLimits(thread);
+    if (stopped) return 0;
+
+    if (ply > 0 && (board.halfmoves() >= 100 || board.isRepetition()))
+        return 0;
+    if (depth <= 0 || ply >= MAX_PLY - 1) return evaluate(board, &thread.pawns);
+
+    TTData entry;
+    ChessMove hashMove;
+    const bool hashHit = table.probe(board.hash(), entry);
+    if (hashHit) {
+        hashMove = entry.move;
+        const int score = scoreFromTable(entry.score, ply);
+        if (ply > 0 && entry.depth >= depth &&
+            (entry.bound == ExactBound ||
+             (entry.bound == LowerBound && score >= beta) ||
+             (entry.bound == UpperBound && score <= alpha)))
+            return score;
+    }
+    if (ply == 0 && !thread.rootBest.isNull()) hashMove = thread.rootBest;
+
+    // with few pieces left the tables know the result, exactly so right
+    // after a capture or pawn move
+    if (ply > 0 && board.halfmoves() == 0 && !board.canCastle() &&
+        popCount(board.occupancy()) <=
+            std::min(settings.probeLimit, tablebaseLargest())) {
+        WdlScore wdl;
+        thread.tbProbes.store(
+            thread.tbProbes.load(std::memory_order_relaxed) + 1,
+            std::memory_order_relaxed);
+        if (probeWdl(board, wdl)) {
+            thread.tbHits.store(
+                thread.tbHits.load(std::memory_order_relaxed) + 1,
+                std::memory_order_relaxed);
+            // cursed wins and blessed losses are draws, by a hair
+            const int score = wdl == WdlWin    ? TB_WIN_SCORE
+                              : wdl == WdlLoss ? -TB_WIN_SCORE
+                                               : 2 * wdl;
+            const Bound bound = wdl == WdlWin    ? LowerBound
+                                : wdl == WdlLoss ? UpperBound
+                                                 : ExactBound;
+            if (bound == ExactBound ||
+                (bound == LowerBound ? score >= beta : score <= alpha)) {
+                table.store(board.hash(), ChessMove(), score, -INFINITE_SCORE,
+                            std::min(depth + TB_DEPTH_BONUS, MAX_PLY - 1),
+                            bound);
+                return score;
+            }
+        }
+    }
+
+    // the table keeps the static eval beside the score, sparing the
+    // evaluation on a revisit; -INFINITE_SCORE when there was none
+    const Color us = board.activeColor;
+    int staticEval = -INFINITE_SCORE;
+    if (!inCheck)
+        staticEval = hashHit && entry.eval != -INFINITE_SCORE
+                         ? entry.eval
+                         : evaluate(board, &thread.pawns);
+
+    // prune whole nodes that look decided without searching their moves
+    if (!pvNode && !inCheck && ply > 0) {
+        // far below alpha: unless a capture helps, nothing will
+        if (settings.razoring && settings.quiescence && depth < RAZOR_DEPTH &&
+            staticEval + settings.razorMargin * depth <= alpha) {
+            const int score = quiesce(thread, ply, alpha, alpha + 1);
+            if (score <= alpha) return score;
+        }
+
+        // far above beta: assume some move keeps it there (reverse futility)
+        if (settings.futility && depth < STATIC_NULL_DEPTH &&
+            std::abs(beta) < MATE_BOUND &&
+            staticEval - settings.futilityMargin * depth >= beta)
+            return staticEval;
+
+        // so far above beta that passing still fails high; never with only
+        // pawns left, where passing may be the best move
+        const Bitboard pieces = board.occupancy(us) &
+                                ~board.occupancy(us, tPawn) &
+                                ~board.occupancy(us, tKing);
+        if (settings.nullMove && allowNull && depth >= NULL_MOVE_DEPTH &&
+            staticEval >= beta && pieces) {
+            const int r = settings.nullMoveReduction + depth / 4;
+            board.makeNullMove();
+            const int score = -negamax(thread, depth - 1 - r, ply + 1, -beta,
+                                       -beta + 1, false);
+            board.unmakeNullMove();
+            if (stopped) return 0;
+            if (score >= beta) return score >= MATE_BOUND ? beta : score;
+        }
+    }
+
+    const ChessMove previous = board.lastMove();
+    const ChessMove counter =
+        previous.isNull() ? ChessMove()
+                          : thread.counterMoves[previous.from()][previous.to()];
+    MovePicker picker(board, hashMove, thread.killers[ply], counter,
+                      thread.history[us]);
+
+    // quiet moves near the horizon cannot lift a hopeless position
+    const bool futile = settings.futility && !pvNode && !inCheck &&
+                        depth < FUTILITY_DEPTH &&
+                        std::abs(alpha) < MATE_BOUND &&
+                        staticEval + settings.futilityMargin * depth <= alpha;
+
+    const int originalAlpha = alpha;
+    int best = -INFINITE_SCORE, legal = 0;
+    ChessMove bestMove;
+    MoveList quiets;
+    for (ChessMove move; !(move = picker.next()).isNull();) {
+        if (!board.isLegal(move)) continue;
+        if (ply == 0 && rootInTables &&
+            std::find(tableMoves.begin(), tableMoves.end(), move) ==
+                tableMoves.end())
+            continue;
+        legal++;
+        const bool quiet = !move.isCapture() && !move.isPromotion();
+
+        board.makeMove(move);
+        const bool givesCheck = board.checkers();
+        if (futile && quiet && !givesCheck && legal > 1) {
+            board.unmakeMove();
+            continue;
+        }
+        // start loading the bucket the child probes while it gets going
+        if (depth > 1) table.prefetch(board.hash());
+        if (quiet) quiets.push(move);
+
+        // the first move gets the full window; the rest are expected to
+        // fail low, so they are tried with a null window, late quiet ones
+        // at reduced depth, and only searched properly if they do not
+        int score;
+        if (legal == 1) {
+            score = -negamax(thread, depth - 1, ply + 1, -beta, -alpha, true);
+        } else {
+            int r = 0;
+            if (settings.lateMoveReductions && depth >= LMR_DEPTH &&
+                legal >= LMR_MOVES && quiet && !inCheck && !givesCheck)
+                r = std::max(0, reduction(depth, legal) - pvNode);
+
+            score = -negamax(thread, depth - 1 - r, ply + 1, -alpha - 1,
+                             -alpha, true);
+            if (r && score > alpha)
+                score = -negamax(thread, depth - 1, ply + 1, -alpha - 1,
+                                 -alpha, true);
+            if (score > alpha && score < beta)
+                score =
+                    -negamax(thread, depth - 1, ply + 1, -beta, -alpha, true);
+        }
+        board.unmakeMove();
+        if (stopped) return 0;
+
+        if (score <= best) continue;
+        best = score;
+        bestMove = move;
+        if (score <= alpha) continue;
+
+        alpha = score;
+        thread.pv[ply][ply] = move;
+        for (int i = ply + 1; i < thread.pvLength[ply + 1]; i++)
+            thread.pv[ply][i] = thread.pv[ply + 1][i];
+        thread.pvLength[ply] = std::max(ply + 1, thread.pvLength[ply + 1]);
+        if (alpha < beta) continue;
+
+        thread.cutoffs++;
+        if (legal == 1) thread.firstMoveCutoffs++;
+        if (quiet) {
+            ChessMove *killers = thread.killers[ply];
+            if (killers[0] != move) {
+                killers[1] = killers[0];
+                killers[0] = move;
+            }
+            if (!previous.isNull())
+                thread.counterMoves[previous.from()][previous.to()] = move;
+
+            // the cutoff move gains and the quiet moves tried before it lose
+            const int bonus = historyBonus(depth);
+            for (ChessMove tried : quiets)
+                updateHistory(thread.history[us][tried.from()][tried.to()],
+                              tried == move ? bonus : -bonus);
+        }
+        break;
+    }
+
+    if (!legal) return inCheck ? -MATE_SCORE + ply : 0;
+
+    const Bound bound = best >= beta            ? LowerBound
+                        : best > originalAlpha ? ExactBound
+                                               : UpperBound;
+    table.store(board.hash(), bound == UpperBound ? ChessMove() : bestMove,
+                scoreToTable(best, ply), staticEval, depth, bound);
+    return best;
+}
+
+// iterative deepening on one thread, until the depth limit or a stop
+void Engine::iterate(SearchThread &thread) {
+    const int maxDepth = limits.depth > 0 ? std::min(limits.depth, MAX_PLY - 1)
+                                          : MAX_PLY - 1;
+
+    for (thread.rootDepth = 1; thread.rootDepth <= maxDepth;
+         thread.rootDepth++) {
+        const int depth = thread.rootDepth;
+        if (thread.id > 0) {
+            const int i = (thread.id - 1) % 20;
+            if (((depth + SKIP_PHASE[i]) / SKIP_SIZE[i]) % 2) continue;
+        }
+
+        int alpha = -INFINITE_SCORE, beta = INFINITE_SCORE;
+        int delta = ASPIRATION_WINDOW;
+        if (depth >= ASPIRATION_DEPTH) {
+            alpha = std::max(thread.bestScore - delta, -INFINITE_SCORE);
+            beta = std::min(thread.bestScore + delta, INFINITE_SCORE);
+        }
+
+        // re-search with a wider window until the score lands inside it
+        int score;
+        for (;;) {
+            score = negamax(thread, depth, 0, alpha, beta, false);
+            if (stopped) break;
+
+            if (score <= alpha) {
+                beta = (alpha + beta) / 2;
+                alpha = std::max(score - delta, -INFINITE_SCORE);
+            } else if (score >= beta) {
+                beta = std::min(score + delta, INFINITE_SCORE);
+            } else {
+                break;
+            }
+            delta += delta / 2;
+        }
+
+        // an interrupted iteration is thrown away
+        if (stopped) break;
+
+        thread.completedDepth = depth;
+        thread.iterationNodes[depth] =
+            thread.nodes.load(std::memory_order_relaxed);
+        thread.bestScore = score;
+        thread.rootBest = thread.pv[0][0];
+        thread.bestLength = thread.pvLength[0];
+        std::copy(thread.pv[0], thread.pv[0] + thread.bestLength,
+                  thread.bestLine);
+
+        if (thread.id != 0) continue;
+        report(thread, depth, score);
+
+        // another iteration would most likely not finish in time
+        if (optimumTime && !limits.infinite && !pondering &&
+            elapsed() > optimumTime / 2)
+            break;
+        if (limits.nodes && nodes() >= limits.nodes) break;
+    }
+}
+
+ChessMove Engine::search(ChessBoard &board,
+                         const SearchLimits &searchLimits) {
+    start = Clock::now();
+    limits = searchLimits;
+    stopped = false;
+    pondering = limits.ponder;
+    bestScore = bestDepth = 0;
+    expectedReply = ChessMove();
+    lastFlush = start;
+    table.newSearch();
+    allocateTime(board.activeColor);
+
+    MoveList rootMoves;
+    board.generateLegalMoves(rootMoves);
+    if (rootMoves.empty()) return ChessMove();
+
+    // the tables rule out the moves that throw the result away
+    rootInTables = !board.canCastle() &&
+                   popCount(board.occupancy()) <= tablebaseLargest() &&
+                   probeRoot(board, rootMoves);
+    tableMoves = rootMoves;
+
+    for (std::unique_ptr<SearchThread> &thread : threads) {
+        thread->board = board;
+        thread->board.refreshAccumulator();
+        thread->nodes = 0;
+        thread->rootDepth = thread->completedDepth = 0;
+        thread->bestScore = 0;
+        thread->rootBest = ChessMove();
+        thread->bestLength = 0;
+        thread->pawns.resetStats();
+        thread->cutoffs = thread->firstMoveCutoffs = 0;
+        thread->tbProbes = thread->tbHits = 0;
+        std::fill(&thread->killers[0][0], &thread->killers[0][0] + 2 * MAX_PLY,
+                  ChessMove());
+    }
+
+    std::vector<std::thread> helpers;
+    for (int i = 1; i < threadCount(); i++)
+        helpers.push_back(
+            std::thread(&Engine::iterate, this, std::ref(*threads[i])));
+
+    // the main thread decides when everyone stops
+    iterate(*threads[0]);
+
+    // the GUI expects no bestmove before it says stop or ponderhit
+    while (!stopped && (limits.infinite || pondering))
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    stopped = true;
+    for (std::thread &helper : helpers) helper.join();
+
+    // a helper that got deeper with a score at least as good wins
+    const SearchThread *best = threads[0].get();
+    for (const std::unique_ptr<SearchThread> &thread : threads)
+        if (thread->completedDepth > best->completedDepth &&
+            thread->bestScore >= best->bestScore && thread->bestLength > 0)
+            best = thread.get();
+
+    bestScore = best->bestScore;
+    bestDepth = best->completedDepth;
+    if (best->bestLength > 1) expectedReply = best->bestLine[1];
+    return best->bestLength > 0 ? best->bestLine[0] : rootMoves[0];
+}
+
+void Engine::report(const SearchThread &thread, int depth,
+                    int score) const {
+    if (!out) return;
+    std::unique_lock<std::mutex> lock;
+    if (outputLock) lock = std::unique_lock<std::mutex>(*outputLock);
+
+    const int ms = elapsed();
+    const uint64_t count = nodes();
+    *out << "info depth " << depth << " score ";
+    if (std::abs(score) >= MATE_BOUND)
+        *out << "mate "
+             << (score > 0 ? (MATE_SCORE - score + 1) / 2
+                           : -(MATE_SCORE + score) / 2);
+    else
+        *out << "cp " << score;
+    *out << " nodes " << count << " nps " << count * 1000 / std::max(ms, 1)
+         << " hashfull " << table.hashfull();
+    if (tablebaseLargest()) *out << " tbhits " << tablebaseHits();
+    *out << " time " << ms << " pv";
+
+    char buf[6];
+    for (int i = 0; i < thread.bestLength; i++)
+        *out << ' ' << thread.bestLine[i].str(buf);
+    *out << '\n';
+
+    if (Clock::now() - lastFlush >= std::chrono::milliseconds(FLUSH_INTERVAL)) {
+        out->flush();
+        lastFlush = Clock::now();
+    }
+}
+
+int searchCommand(int argc, char **argv) {
+    SearchLimits limits;
+    SearchOptions options;
+    const char *fen = NULL;
+    int hash = 0, threads = 1;
+
+    for (int i = 0; i < argc; i++) {
+        const char *option = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (!strcmp(option, "--depth") && hasValue)
+            limits.depth = atoi(argv[++i]);
+        else if (!strcmp(option, "--nodes") && hasValue)
+            limits.nodes = strtoull(argv[++i], NULL, 10);
+        else if (!strcmp(option, "--movetime") && hasValue)
+            limits.movetime = atoi(argv[++i]);
+        else if (!strcmp(option, "--wtime") && hasValue)
+            limits.time[White] = atoi(argv[++i]);
+        else if (!strcmp(option, "--btime") && hasValue)
+            limits.time[Black] = atoi(argv[++i]);
+        else if (!strcmp(option, "--winc") && hasValue)
+            limits.increment[White] = atoi(argv[++i]);
+        else if (!strcmp(option, "--binc") && hasValue)
+            limits.increment[Black] = atoi(argv[++i]);
+        else if (!strcmp(option, "--movestogo") && hasValue)
+            limits.movestogo = atoi(argv[++i]);
+        else if (!strcmp(option, "--hash") && hasValue)
+            hash = atoi(argv[++i]);
+        else if (!strcmp(option, "--threads") && hasValue)
+            threads = atoi(argv[++i]);
+        else if (!strcmp(option, "--disable") && hasValue) {
+            if (!disableFeatures(options, argv[++i])) {
+                std::cout << "unknown feature in: " << argv[i] << std::endl;
+                return 1;
+            }
+        } else if (!strcmp(option, "--syzygy") && hasValue) {
+            std::cout << "info string found " << initTablebases(argv[++i])
+                      << " tablebases" << std::endl;
+        } else if (!strcmp(option, "--nnue") && hasValue) {
+            if (!loadNetwork(argv[++i])) {
+                std::cout << "cannot load network: " << argv[i] << std::endl;
+                return 1;
+            }
+        } else
+            fen = option;
+    }
+
+    // with nothing else to go on, think for a few seconds
+    if (!limits.depth && !limits.nodes && !limits.movetime &&
+        !limits.time[White] && !limits.time[Black])
+        limits.movetime = 5000;
+
+    ChessBoard board;
+    if (fen && !board.setFen(fen)) {
+        std::cout << "invalid fen: " << fen << std::endl;
+        return 1;
+    }
+
+    Engine engine;
+    engine.setOutput(&std::cout);
+    engine.setThreads(threads);
+    engine.setOptions(options);
+    if (hash > 0 && !engine.setHashSize(hash))
+        std::cout << "info string cannot allocate " << hash << " MB of hash, "
+                  << "using " << engine.hashSize() << " MB" << std::endl;
+    ChessMove best = engine.search(board, limits);
+
+    const int hits = engine.pawnHits();
+    const int firstMove = engine.firstMoveCutoffs();
+    std::cout << "info string pawn table hits " << hits / 10 << '.'
+              << hits % 10 << "%, first move cutoffs " << firstMove / 10
+              << '.' << firstMove % 10 << '%' << std::endl;
+    if (tablebaseLargest())
+        std::cout << "info string tablebase hits " << engine.tablebaseHits()
+                  << " of " << engine.tablebaseProbes() << " probes"
+                  << std::endl;
+    char buf[6];
+    std::cout << "bestmove " << (best.isNull() ? "0000" : best.str(buf))
+              << std::endl;
+    return 0;
+}
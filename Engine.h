@@ -0,0 +1,192 @@
+#ifndef ENGINE_H
+#define ENGINE_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iosfwd>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "ChessBoard.h"
+#include "ChessMove.h"
+#include "MovePicker.h"
+#include "PawnTable.h"
+#include "TranspositionTable.h"
+
+const int MAX_PLY = 128;
+const int INFINITE_SCORE = 32001;
+const int MATE_SCORE = 32000;
+// scores beyond this are mates, MATE_SCORE - plies to mate
+const int MATE_BOUND = MATE_SCORE - MAX_PLY;
+
+// what the search may spend; zero means no limit of that kind
+struct SearchLimits {
+    int depth;
+    uint64_t nodes;
+    int movetime;      // ms for this move
+    int time[2];       // ms left on each clock, indexed by Color
+    int increment[2];  // ms added per move, indexed by Color
+    int movestogo;
+    bool infinite;
+    bool ponder;  // searching the expected reply until ponderhit
+
+    SearchLimits();
+};
+
+// the selective parts of the search, each of which can be switched off to
+// measure what it is worth; all are on by default, and plain() turns every
+// one off for a fixed-depth alpha-beta search
+struct SearchOptions {
+    bool quiescence;  // search captures past the horizon
+    bool nullMove;
+    int nullMoveReduction;  // plies, before the depth-dependent part
+    bool lateMoveReductions;
+    // skip quiet moves, and nodes, hopelessly far from the window near the
+    // horizon; the margin is in centipawns per ply of depth
+    bool futility;
+    int futilityMargin;
+    // drop into the quiescence search from far below alpha
+    bool razoring;
+    int razorMargin;
+    bool checkExtensions;
+    // most pieces at which the endgame tables are probed inside the tree
+    int probeLimit;
+
+    SearchOptions();
+    static SearchOptions plain();
+};
+
+// everything one search thread owns: its own copy of the board, pawn
+// table, principal variation and counters
+struct SearchThread {
+    int id;
+    ChessBoard board;
+    PawnTable pawns;
+    std::atomic<uint64_t> nodes;
+
+    int rootDepth;
+    int completedDepth;
+    int bestScore;
+    ChessMove rootBest;
+
+    ChessMove pv[MAX_PLY][MAX_PLY];
+    int pvLength[MAX_PLY];
+    ChessMove bestLine[MAX_PLY];
+    int bestLength;
+
+    // move ordering: two killers per ply, the quiet move that last refuted
+    // each opponent move (by its origin and destination), and quiet move
+    // history by side, origin and destination
+    ChessMove killers[MAX_PLY][2];
+    ChessMove counterMoves[64][64];
+    int history[2][64][64];
+    // beta cutoffs, and those caused by the first legal move
+    uint64_t cutoffs;
+    uint64_t firstMoveCutoffs;
+    // endgame table probes in the tree, and those that found the position
+    std::atomic<uint64_t> tbProbes;
+    std::atomic<uint64_t> tbHits;
+    // total nodes when each iteration completed, for the branching factor
+    uint64_t iterationNodes[MAX_PLY];
+
+    explicit SearchThread(int);
+    // forgets the counter moves and history, for a new game
+    void clearHistory();
+};
+
+// negamax alpha-beta searcher with iterative deepening and aspiration
+// windows. With more than one thread it runs a lazy SMP search: every
+// thread searches the whole tree on its own board, sharing only the
+// transposition table, and helpers skip some depths so they spread out.
+// search() may be stopped from another thread at any time.
+class Engine {
+   public:
+    Engine();
+    Engine(const Engine &) = delete;
+    Engine &operator=(const Engine &) = delete;
+
+    // reports each completed iteration as a UCI info line; NULL is silent.
+    // Lines are buffered and the stream is flushed at most every
+    // FLUSH_INTERVAL ms; the mutex, if given, is held while writing.
+    void setOutput(std::ostream *, std::mutex * = NULL);
+
+    // transposition table size in MB, false if it could not be had, and
+    // clearing it, the pawn tables and the move ordering history for a new
+    // game
+    bool setHashSize(size_t megabytes);
+    size_t hashSize() const;
+    void clearHash();
+    void setThreads(int);
+    int threadCount() const;
+    // only to be changed between searches
+    void setOptions(const SearchOptions &);
+    const SearchOptions &options() const;
+
+    // the best move found within the limits; the board is left as given.
+    // An infinite or pondering search only returns once stopped.
+    ChessMove search(ChessBoard &, const SearchLimits &);
+    void stop();
+    // the opponent played the expected move: the clock now applies
+    void ponderhit();
+
+    uint64_t nodes() const;
+    // permille of pawn table probes that hit during the last search, over
+    // every thread
+    int pawnHits() const;
+    // permille of beta cutoffs during the last search that came from the
+    // first move tried, the measure of move ordering
+    int firstMoveCutoffs() const;
+    // endgame table probes during the last search and how many succeeded
+    uint64_t tablebaseProbes() const;
+    uint64_t tablebaseHits() const;
+    // the main thread's nodes for its last completed iteration over the
+    // one before, or 0 before there are two
+    double branchingFactor() const;
+    int score() const;
+    int depth() const;
+    // the reply expected after the best move, or a null move
+    ChessMove ponderMove() const;
+
+   private:
+    typedef std::chrono::steady_clock Clock;
+
+    SearchLimits limits;
+    SearchOptions settings;
+    Clock::time_point start;
+    int optimumTime;
+    int maximumTime;
+
+    std::atomic<bool> stopped;
+    std::atomic<bool> pondering;
+    int bestScore;
+    int bestDepth;
+    ChessMove expectedReply;
+    // the root moves the endgame tables allow, when they cover the root
+    bool rootInTables;
+    MoveList tableMoves;
+    std::ostream *out;
+    std::mutex *outputLock;
+    mutable Clock::time_point lastFlush;
+    TranspositionTable table;
+    std::vector<std::unique_ptr<SearchThread> > threads;
+
+    void iterate(SearchThread &);
+    int negamax(SearchThread &, int depth, int ply, int alpha, int beta,
+                bool allowNull);
+    int quiesce(SearchThread &, int ply, int alpha, int beta);
+    void allocateTime(int color);
+    void checkLimits(SearchThread &);
+    int elapsed() const;
+    void report(const SearchThread &, int depth, int score) const;
+};
+
+// turns off the named features in a comma-separated list of qsearch, null,
+// lmr, futility, razoring, extensions or all; false on an unknown name
+bool disableFeatures(SearchOptions &, const char *list);
+
+// entry point for "chess search [fen] [--depth n] [--movetime ms] ..."
+int searchCommand(int argc, char **argv);
+
+#endif
@@ -0,0 +1,204 @@
+#include "Epd.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "ChessBoard.h"
+#include "ThreadPool.h"
+
+using std::chrono::steady_clock;
+
+// lines read between handing them to the pool, and lines per task
+const int BATCH_LINES = 1 << 16;
+const int LINES_PER_TASK = 4096;
+
+bool splitEpd(std::string_view line, EpdRecord &record) {
+    size_t i = 0;
+    for (int field = 0; field < 4; field++) {
+        while (i < line.size() && line[i] == ' ') i++;
+        if (i == line.size()) return false;
+        while (i < line.size() && line[i] != ' ') i++;
+    }
+    record.fen = line.substr(0, i);
+
+    while (i < line.size() && line[i] == ' ') i++;
+    record.operations = line.substr(i);
+    return true;
+}
+
+EpdFile::EpdFile(const char *path) : data(NULL), length(0), offset(0) {
+    const int fd = open(path, O_RDONLY);
+    if (fd < 0) return;
+
+    struct stat info;
+    if (fstat(fd, &info) == 0 && info.st_size > 0) {
+        void *map = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (map != MAP_FAILED) {
+            madvise(map, info.st_size, MADV_SEQUENTIAL);
+            data = static_cast<const char *>(map);
+            length = info.st_size;
+        }
+    }
+    // the mapping outlives the descriptor
+    close(fd);
+}
+
+EpdFile::~EpdFile() {
+    if (data) munmap(const_cast<char *>(data), length);
+}
+
+bool EpdFile::isOpen() const { return data != NULL; }
+size_t EpdFile::size() const { return length; }
+void EpdFile::rewind() { offset = 0; }
+
+bool EpdFile::nextLine(std::string_view &line) {
+    while (offset < length) {
+        const char *start = data + offset;
+        const char *end =
+            static_cast<const char *>(memchr(start, '\n', length - offset));
+        if (!end) end = data + length;
+        offset = end - data + 1;
+
+        size_t size = end - start;
+        if (size && start[size - 1] == '\r') size--;
+        if (size) {
+            line = std::string_view(start, size);
+            return true;
+        }
+    }
+    return false;
+}
+
+// whether the first four fields of a and b agree, ignoring extra spaces
+static bool sameFields(std::string_view a, std::string_view b) {
+    EpdRecord x, y;
+    if (!splitEpd(a, x) || !splitEpd(b, y)) return false;
+
+    size_t i = 0, j = 0;
+    for (;;) {
+        while (i < x.fen.size() && x.fen[i] == ' ' && i > 0 &&
+               x.fen[i - 1] == ' ')
+            i++;
+        while (j < y.fen.size() && y.fen[j] == ' ' && j > 0 &&
+               y.fen[j - 1] == ' ')
+            j++;
+        if (i == x.fen.size() || j == y.fen.size())
+            return i == x.fen.size() && j == y.fen.size();
+        if (x.fen[i++] != y.fen[j++]) return false;
+    }
+}
+
+// how a line fared, filled in by the workers and reported in order
+enum LineStatus : uint8_t { LineRead, LineInvalid, LineDiffers };
+
+bool loadEpd(const char *path, bool check, int threads, std::ostream &os) {
+    const steady_clock::time_point start = steady_clock::now();
+    EpdFile file(path);
+    if (!file.isOpen()) {
+        os << "cannot read " << path << std::endl;
+        return false;
+    }
+
+    // each position is only parsed, into its packed form, unless it is to
+    // be checked against what the board writes back
+    ThreadPool pool(threads);
+    std::vector<ChessBoard> boards(check ? pool.size() : 0);
+    for (ChessBoard &board : boards) board.setOutput(NULL);
+
+    std::vector<std::string_view> lines;
+    std::vector<LineStatus> status;
+    lines.reserve(BATCH_LINES);
+    uint64_t positions = 0, invalid = 0, mismatched = 0;
+    ChessBoard board;
+    char fen[MAX_FEN];
+    for (bool more = true; more;) {
+        lines.clear();
+        std::string_view line;
+        while (int(lines.size()) < BATCH_LINES && (more = file.nextLine(line)))
+            lines.push_back(line);
+
+        status.resize(lines.size());
+        for (size_t begin = 0; begin < lines.size(); begin += LINES_PER_TASK) {
+            const size_t end = std::min(begin + LINES_PER_TASK, lines.size());
+            pool.submit([&boards, &lines, &status, check, begin, end](int id) {
+                EpdRecord record;
+                PackedPosition packed;
+                char written[MAX_FEN];
+                for (size_t i = begin; i < end; i++) {
+                    if (!splitEpd(lines[i], record) ||
+                        !packFen(record.fen, packed)) {
+                        status[i] = LineInvalid;
+                    } else if (check) {
+                        boards[id].unpack(packed);
+                        status[i] = sameFields(boards[id].toFen(written),
+                                               record.fen)
+                                        ? LineRead
+                                        : LineDiffers;
+                    } else {
+                        status[i] = LineRead;
+                    }
+                }
+            });
+        }
+        pool.wait();
+
+        for (size_t i = 0; i < lines.size(); i++) {
+            if (status[i] == LineInvalid) {
+                if (invalid++ < 10) os << "invalid: " << lines[i] << '\n';
+                continue;
+            }
+            positions++;
+            if (status[i] == LineDiffers && mismatched++ < 10) {
+                EpdRecord record;
+                splitEpd(lines[i], record);
+                board.setFen(record.fen);
+                os << "read:    " << record.fen
+                   << "\nwritten: " << board.toFen(fen) << '\n';
+            }
+        }
+    }
+
+    const double seconds =
+        std::chrono::duration<double>(steady_clock::now() - start).count();
+    os << "positions " << positions << '\n'
+       << "invalid   " << invalid << '\n';
+    if (check) os << "differing " << mismatched << '\n';
+    os << "time      " << std::fixed << std::setprecision(3) << seconds
+       << " s on " << pool.size() << " threads\n"
+       << "rate      " << std::setprecision(0)
+       << (seconds > 0 ? positions / seconds : 0) << " positions/s"
+       << std::endl;
+    return invalid == 0;
+}
+
+int epdCommand(int argc, char **argv) {
+    const char *path = NULL;
+    bool check = false;
+    int threads = int(std::max(1u, std::thread::hardware_concurrency()));
+    for (int i = 0; i < argc; i++) {
+        if (!strcmp(argv[i], "--check"))
+            check = true;
+        else if (!strcmp(argv[i], "--threads") && i + 1 < argc)
+            threads = std::max(1, atoi(argv[++i]));
+        else
+            path = argv[i];
+    }
+
+    if (!path) {
+        std::cout << "usage: chess epd <file> [--check] [--threads n]"
+                  << std::endl;
+        return 1;
+    }
+    return loadEpd(path, check, threads, std::cout) ? 0 : 1;
+}
@@ -0,0 +1,49 @@
+#ifndef EPD_H
+#define EPD_H
+
+#include <cstddef>
+#include <iosfwd>
+#include <string_view>
+
+// an EPD line split into its position, the first four FEN fields, and the
+// operations after them ("bm e4; id \"x\";"); both view the line itself
+struct EpdRecord {
+    std::string_view fen;
+    std::string_view operations;
+};
+
+// splits one line; false if it has fewer than four fields
+bool splitEpd(std::string_view line, EpdRecord &);
+
+// a read-only memory-mapped EPD or FEN file walked line by line without
+// copying; the views it hands out live as long as the file
+class EpdFile {
+   public:
+    explicit EpdFile(const char *path);
+    EpdFile(const EpdFile &) = delete;
+    EpdFile &operator=(const EpdFile &) = delete;
+    ~EpdFile();
+
+    bool isOpen() const;
+    size_t size() const;
+
+    // the next non-blank line without its line ending; false at the end
+    bool nextLine(std::string_view &);
+    void rewind();
+
+   private:
+    const char *data;
+    size_t length;
+    size_t offset;
+};
+
+// reads every position of the file into its packed form on the given
+// number of threads, optionally setting each up on a board to check that
+// toFen gives it back; prints positions per second and returns whether
+// every line parsed
+bool loadEpd(const char *path, bool check, int threads, std::ostream &);
+
+// entry point for "chess epd <file> [--check] [--threads n]"
+int epdCommand(int argc, char **argv);
+
+#endif
@@ -0,0 +1,158 @@
+#include "Evaluation.h"
+
+#include <algorithm>
+
+#include "ChessBoard.h"
+#include "ChessPiece.h"
+#include "PawnTable.h"
+
+#define S(mg, eg) makeScore(mg, eg)
+
+const Score DOUBLED = S(-10, -20);
+const Score ISOLATED = S(-10, -15);
+// by how far the pawn has come, its own rank 1 first
+const Score PASSED[8] = {S(0, 0),   S(5, 10),  S(10, 15), S(15, 25),
+                         S(30, 45), S(50, 75), S(80, 120), S(0, 0)};
+const Score KING_SHIELD = S(10, 0);
+
+// per square reachable beyond a typical count, indexed by Type
+const Score MOBILITY[6] = {S(0, 0), S(2, 4), S(4, 4),
+                           S(5, 5), S(0, 0), S(1, 2)};
+const int TYPICAL_MOBILITY[6] = {0, 7, 4, 6, 0, 14};
+
+// how much an attack on a square next to the enemy king counts, by Type
+const int KING_ATTACK_WEIGHT[6] = {0, 3, 2, 2, 0, 5};
+const int MAX_KING_DANGER = 600;
+
+const int TEMPO = 10;
+
+#undef S
+
+Bitboard pawnAttackSpan(Bitboard pawns, Color color) {
+    const Bitboard west = pawns & ~fileBB(0), east = pawns & ~fileBB(7);
+    // white pawns advance towards lower squares
+    return color == White ? shift(west, -9) | shift(east, -7)
+                          : shift(west, 7) | shift(east, 9);
+}
+
+// the ranks in front of sq as seen by color
+static Bitboard forwardRanks(Color color, int sq) {
+    const int rank = rankOf(sq);
+    if (color == White) return rank ? ~Bitboard(0) >> (64 - 8 * rank) : 0;
+    return rank < 7 ? ~Bitboard(0) << (8 * (rank + 1)) : 0;
+}
+
+static Bitboard adjacentFiles(int file) {
+    return (file > 0 ? fileBB(file - 1) : 0) | (file < 7 ? fileBB(file + 1) : 0);
+}
+
+Score evaluatePawns(const ChessBoard &board, Color us) {
+    const Color them = ChessBoard::opposite(us);
+    const Bitboard ours = board.occupancy(us, tPawn);
+    const Bitboard theirs = board.occupancy(them, tPawn);
+
+    Score score = 0;
+    for (Bitboard b = ours; b;) {
+        const int sq = popLsb(b), file = fileOf(sq);
+        const Bitboard ahead = forwardRanks(us, sq);
+        const Bitboard neighbours = adjacentFiles(file);
+
+        if (ours & ahead & fileBB(file)) score += DOUBLED;
+        if (!(ours & neighbours)) score += ISOLATED;
+        if (!(theirs & ahead & (neighbours | fileBB(file)))) {
+            const int progress = us == White ? 7 - rankOf(sq) : rankOf(sq);
+            score += PASSED[progress];
+        }
+    }
+    return score;
+}
+
+static void evaluatePawnStructure(const ChessBoard &board, PawnEntry &entry) {
+    entry.key = board.pawnHash();
+    entry.score = evaluatePawns(board, White) - evaluatePawns(board, Black);
+    for (Color color : {Black, White})
+        entry.attackSpan[color] =
+            pawnAttackSpan(board.occupancy(color, tPawn), color);
+}
+
+// mobility of every piece and the pressure it puts on the enemy king,
+// kept out of squares the enemy pawns attack
+static Score evaluatePieces(const ChessBoard &board, Color us,
+                            Bitboard enemyPawnSpan) {
+    const Color them = ChessBoard::opposite(us);
+    const Bitboard occupied = board.occupancy();
+    const Bitboard area =
+        ~(board.occupancy(us, tPawn) | board.occupancy(us, tKing)) &
+        ~enemyPawnSpan;
+
+    const int enemyKing = lsb(board.occupancy(them, tKing));
+    const Bitboard kingZone = kingAttacks[enemyKing] | squareBB(enemyKing);
+
+    Score score = 0;
+    int attackers = 0, danger = 0;
+    for (int type = tRook; type <= tQueen; type++) {
+        if (type == tKing) continue;
+        for (Bitboard b = board.occupancy(us, Type(type)); b;) {
+            const int sq = popLsb(b);
+            Bitboard attacks;
+            switch (type) {
+                case tRook:
+                    attacks = rookAttacks(sq, occupied);
+                    break;
+                case tKnight:
+                    attacks = knightAttacks[sq];
+                    break;
+                case tBishop:
+                    attacks = bishopAttacks(sq, occupied);
+                    break;
+                default:
+                    attacks = queenAttacks(sq, occupied);
+                    break;
+            }
+
+            score += MOBILITY[type] *
+                     (popCount(attacks & area) - TYPICAL_MOBILITY[type]);
+            if (attacks & kingZone) {
+                attackers++;
+                danger += KING_ATTACK_WEIGHT[type] *
+                          popCount(attacks & kingZone);
+            }
+        }
+    }
+
+    // one piece near the king is rarely a threat; several grow quickly
+    if (attackers >= 2) {
+        danger = std::min(danger * danger / 4, MAX_KING_DANGER);
+        score += makeScore(danger, danger / 4);
+    }
+
+    // pawns on the two ranks in front of our own king
+    const int king = lsb(board.occupancy(us, tKing));
+    const int forward = us == White ? -8 : 8;
+    const Bitboard rank = rankBB(rankOf(king));
+    const Bitboard shield = (shift(rank, forward) | shift(rank, 2 * forward)) &
+                            (adjacentFiles(fileOf(king)) | fileBB(fileOf(king)));
+    score += KING_SHIELD * popCount(board.occupancy(us, tPawn) & shield);
+    return score;
+}
+
+int evaluate(const ChessBoard &board, PawnTable *pawnTable) {
+    if (const Accumulator *accumulator = board.accumulator())
+        return evaluateNnue(*accumulator, board.activeColor) + TEMPO;
+
+    PawnEntry scratch;
+    PawnEntry *pawns = &scratch;
+    if (pawnTable) pawns = pawnTable->probe(board.pawnHash());
+    if (!pawnTable || pawns->key != board.pawnHash())
+        evaluatePawnStructure(board, *pawns);
+
+    Score score = board.psqScore() + pawns->score;
+    score += evaluatePieces(board, White, pawns->attackSpan[Black]) -
+             evaluatePieces(board, Black, pawns->attackSpan[White]);
+
+    const int phase = std::min(board.gamePhase(), MAX_PHASE);
+    const int value = (mgValue(score) * phase +
+                       egValue(score) * (MAX_PHASE - phase)) /
+                      MAX_PHASE;
+    return (board.activeColor == White ? value : -value) + TEMPO;
+}
@@ -0,0 +1,27 @@
+#ifndef EVALUATION_H
+#define EVALUATION_H
+
+#include <cstddef>
+
+#include "Bitboard.h"
+#include "Psqt.h"
+
+class ChessBoard;
+class PawnTable;
+enum Color : int;
+
+// static score of a position in centipawns from the side to move's point
+// of view: the board's incremental material and piece-square score plus
+// pawn structure, mobility and king safety, blended from middlegame to
+// endgame values by the game phase; or the network's score, when the
+// board keeps an accumulator. The pawn structure terms come from the pawn
+// table when one is given.
+int evaluate(const ChessBoard &, PawnTable * = NULL);
+
+// the pawn structure terms for one side: doubled, isolated and passed pawns
+Score evaluatePawns(const ChessBoard &, Color);
+
+// every square attacked by the color's pawns
+Bitboard pawnAttackSpan(Bitboard pawns, Color);
+
+#endif
@@ -0,0 +1,152 @@
+#include "MovePicker.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+#include "ChessBoard.h"
+#include "ChessPiece.h"
+
+// rough material values for MVV-LVA, indexed by Type
+static const int ORDER_VALUE[6] = {1, 5, 3, 3, 10, 9};
+// the piece a promotion makes, by the flag's low two bits
+static const Type PROMOTED[4] = {tKnight, tBishop, tRook, tQueen};
+
+MovePicker::MovePicker(const ChessBoard &chessBoard, ChessMove hashMove,
+                       const ChessMove killerMoves[2], ChessMove counterMove,
+                       const int historyScores[64][64])
+    : board(chessBoard),
+      ttMove(hashMove),
+      counter(counterMove),
+      history(historyScores),
+      current(TTMoveStage),
+      capturesOnly(false),
+      index(0),
+      badCaptures(0),
+      badIndex(0) {
+    killers[0] = killerMoves[0];
+    killers[1] = killerMoves[1];
+}
+
+MovePicker::MovePicker(const ChessBoard &chessBoard)
+    : board(chessBoard),
+      history(NULL),
+      current(GenerateCaptures),
+      capturesOnly(true),
+      index(0),
+      badCaptures(0),
+      badIndex(0) {}
+
+PickStage MovePicker::stage() const { return current; }
+
+// whether an earlier stage already handed the move out
+bool MovePicker::tried(ChessMove move) const {
+    if (move == ttMove) return true;
+    if (move.isCapture() || move.isPromotion()) return false;
+    return move == killers[0] || move == killers[1] || move == counter;
+}
+
+// selection sort, one step at a time: most nodes cut off after the first
+// few moves, so sorting the whole list would be wasted
+ChessMove MovePicker::pickBest() {
+    int best = index;
+    for (int i = index + 1; i < moves.size(); i++)
+        if (scores[i] > scores[best]) best = i;
+    std::swap(moves[index], moves[best]);
+    std::swap(scores[index], scores[best]);
+    return moves[index++];
+}
+
+void MovePicker::scoreCaptures() {
+    for (int i = 0; i < moves.size(); i++) {
+        const ChessMove move = moves[i];
+        const int attacker = board.pieceAt(move.from())->type();
+        int victim = tPawn;
+        if (move.isCapture() && move.flag() != EnPassant)
+            victim = board.pieceAt(move.to())->type();
+        scores[i] = move.isCapture()
+                        ? ORDER_VALUE[victim] * 16 - ORDER_VALUE[attacker]
+                        : 0;
+        if (move.isPromotion())
+            scores[i] += ORDER_VALUE[PROMOTED[move.flag() & 3]] * 16;
+    }
+}
+
+void MovePicker::scoreQuiets(int first) {
+    for (int i = first; i < moves.size(); i++)
+        scores[i] = history[moves[i].from()][moves[i].to()];
+}
+
+ChessMove MovePicker::next() {
+    switch (current) {
+        case TTMoveStage:
+            current = GenerateCaptures;
+            if (board.isPseudoLegal(ttMove)) return ttMove;
+            // fall through
+        case GenerateCaptures:
+            board.generateCaptures(moves);
+            scoreCaptures();
+            current = GoodCaptures;
+            // fall through
+        case GoodCaptures:
+            while (index < moves.size()) {
+                const ChessMove move = pickBest();
+                if (tried(move)) continue;
+                if (board.see(move)) return move;
+                moves[badCaptures++] = move;
+            }
+            if (capturesOnly) {
+                current = Done;
+                break;
+            }
+            current = FirstKiller;
+            // fall through
+        case FirstKiller:
+            current = SecondKiller;
+            if (killers[0] != ttMove && board.isPseudoLegal(killers[0]))
+                return killers[0];
+            // fall through
+        case SecondKiller:
+            current = CounterMove;
+            if (killers[1] != ttMove && killers[1] != killers[0] &&
+                board.isPseudoLegal(killers[1]))
+                return killers[1];
+            // fall through
+        case CounterMove:
+            current = GenerateQuiets;
+            if (counter != ttMove && counter != killers[0] &&
+                counter != killers[1] && !counter.isCapture() &&
+                board.isPseudoLegal(counter))
+                return counter;
+            // fall through
+        case GenerateQuiets: {
+            const int first = moves.size();
+            board.generateQuiets(moves);
+            scoreQuiets(first);
+            current = QuietMoves;
+        }
+            // fall through
+        case QuietMoves:
+            while (index < moves.size()) {
+                const ChessMove move = pickBest();
+                if (!tried(move)) return move;
+            }
+            current = BadCaptures;
+            // fall through
+        case BadCaptures:
+            // already in MVV-LVA order
+            if (badIndex < badCaptures) return moves[badIndex++];
+            current = Done;
+            // fall through
+        case Done:
+            break;
+    }
+    return ChessMove();
+}
+
+int historyBonus(int depth) { return std::min(depth * depth, 400); }
+
+// the further the score already is in the bonus' direction, the less it
+// moves, so it never leaves [-MAX_HISTORY, MAX_HISTORY]
+void updateHistory(int &score, int bonus) {
+    score += bonus - score * std::abs(bonus) / MAX_HISTORY;
+}
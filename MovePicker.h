@@ -0,0 +1,72 @@
+#ifndef MOVEPICKER_H
+#define MOVEPICKER_H
+
+#include "ChessMove.h"
+
+class ChessBoard;
+
+// the order moves are handed out in; each stage is only generated once the
+// one before it has run dry, so a cutoff skips the rest
+enum PickStage {
+    TTMoveStage,
+    GenerateCaptures,
+    GoodCaptures,
+    FirstKiller,
+    SecondKiller,
+    CounterMove,
+    GenerateQuiets,
+    QuietMoves,
+    BadCaptures,
+    Done
+};
+
+// history scores stay within this bound either way
+const int MAX_HISTORY = 16384;
+
+// hands out the pseudo-legal moves of a position best first: the
+// transposition table move, captures by most valuable victim and least
+// valuable attacker, the two killers of this ply, the move that last
+// refuted the opponent's previous move, the remaining quiet moves by
+// history score, and last the captures that lose material by static
+// exchange. Moves remembered from elsewhere are checked with isPseudoLegal
+// and never handed out twice.
+class MovePicker {
+   public:
+    MovePicker(const ChessBoard &, ChessMove ttMove, const ChessMove killers[2],
+               ChessMove counter, const int history[64][64]);
+    // for the quiescence search: the captures and promotions that do not
+    // lose material, and nothing else
+    explicit MovePicker(const ChessBoard &);
+
+    // the next move, or a null move once there are none left
+    ChessMove next();
+    PickStage stage() const;
+
+   private:
+    const ChessBoard &board;
+    ChessMove ttMove;
+    ChessMove killers[2];
+    ChessMove counter;
+    const int (*history)[64];
+
+    PickStage current;
+    bool capturesOnly;
+    MoveList moves;
+    int scores[MAX_MOVES];
+    int index;
+    // losing captures are set aside at the front of moves, behind index
+    int badCaptures;
+    int badIndex;
+
+    bool tried(ChessMove) const;
+    ChessMove pickBest();
+    void scoreCaptures();
+    void scoreQuiets(int first);
+};
+
+// the bonus for a quiet move that caused a cutoff at the given depth, and
+// the update pulling a history score towards it without overflowing
+int historyBonus(int depth);
+void updateHistory(int &score, int bonus);
+
+#endif
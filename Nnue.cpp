@@ -0,0 +1,323 @@
+#include "Nnue.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <memory>
+
+#include "ChessPiece.h"
+#include "Psqt.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define NNUE_X86
+#endif
+
+// a network file holds, little-endian: the magic, the hidden size, then
+// the Network arrays in order
+const uint32_t NNUE_MAGIC = 0x454e4e43;  // "CNNE"
+
+// hidden outputs are clipped to [0, CLIP]; the output sum is divided by
+// OUTPUT_SCALE to give centipawns
+const int CLIP = 255;
+const int OUTPUT_SCALE = 16;
+
+// output weights and bias a network may have, so that the output sum
+// stays within int32 in every kernel: 2 * NNUE_HIDDEN * CLIP * 8192 is
+// under 2^30, as is the bias
+const int MAX_OUTPUT_WEIGHT = 8192;
+const int32_t MAX_OUTPUT_BIAS = 1 << 30;
+
+struct Network {
+    alignas(64) int16_t featureWeights[NNUE_FEATURES][NNUE_HIDDEN];
+    alignas(64) int16_t featureBias[NNUE_HIDDEN];
+    // the side to move's half first, then the other side's
+    alignas(64) int16_t outputWeights[2 * NNUE_HIDDEN];
+    int32_t outputBias;
+};
+
+static Network network;
+static bool loaded = false;
+static bool enabled = true;
+
+// each perspective sees its own pieces first, from its own side
+static int featureIndex(Color perspective, Color color, Type type, int sq) {
+    if (perspective == White)
+        return (color == White ? 0 : 384) + type * 64 + sq;
+    return (color == Black ? 0 : 384) + type * 64 + (sq ^ 56);
+}
+
+static void addScalar(int16_t *values, const int16_t *weights) {
+    for (int i = 0; i < NNUE_HIDDEN; i++) values[i] += weights[i];
+}
+
+static void subtractScalar(int16_t *values, const int16_t *weights) {
+    for (int i = 0; i < NNUE_HIDDEN; i++) values[i] -= weights[i];
+}
+
+static int32_t outputScalar(const int16_t *us, const int16_t *them,
+                            const int16_t *weights) {
+    int32_t sum = 0;
+    for (int i = 0; i < NNUE_HIDDEN; i++) {
+        sum += std::min(std::max(int(us[i]), 0), CLIP) * weights[i];
+        sum += std::min(std::max(int(them[i]), 0), CLIP) *
+               weights[NNUE_HIDDEN + i];
+    }
+    return sum;
+}
+
+#ifdef NNUE_X86
+__attribute__((target("avx2"))) static void addAvx2(int16_t *values,
+                                                    const int16_t *weights) {
+    __m256i *v = reinterpret_cast<__m256i *>(values);
+    const __m256i *w = reinterpret_cast<const __m256i *>(weights);
+    for (int i = 0; i < NNUE_HIDDEN / 16; i++)
+        v[i] = _mm256_add_epi16(v[i], w[i]);
+}
+
+__attribute__((target("avx2"))) static void subtractAvx2(
+    int16_t *values, const int16_t *weights) {
+    __m256i *v = reinterpret_cast<__m256i *>(values);
+    const __m256i *w = reinterpret_cast<const __m256i *>(weights);
+    for (int i = 0; i < NNUE_HIDDEN / 16; i++)
+        v[i] = _mm256_sub_epi16(v[i], w[i]);
+}
+
+// clip to [0, CLIP], then multiply pairs of int16 into int32 sums
+__attribute__((target("avx2"))) static int32_t outputAvx2(
+    const int16_t *us, const int16_t *them, const int16_t *weights) {
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i clip = _mm256_set1_epi16(CLIP);
+    const int16_t *halves[2] = {us, them};
+
+    __m256i sum = _mm256_setzero_si256();
+    for (int half = 0; half < 2; half++) {
+        const __m256i *v = reinterpret_cast<const __m256i *>(halves[half]);
+        const __m256i *w =
+            reinterpret_cast<const __m256i *>(weights + half * NNUE_HIDDEN);
+        for (int i = 0; i < NNUE_HIDDEN / 16; i++) {
+            const __m256i clipped =
+                _mm256_min_epi16(_mm256_max_epi16(v[i], zero), clip);
+            sum = _mm256_add_epi32(sum, _mm256_madd_epi16(clipped, w[i]));
+        }
+    }
+
+    __m128i folded = _mm_add_epi32(_mm256_castsi256_si128(sum),
+                                   _mm256_extracti128_si256(sum, 1));
+    folded = _mm_add_epi32(folded, _mm_shuffle_epi32(folded, 0x4E));
+    folded = _mm_add_epi32(folded, _mm_shuffle_epi32(folded, 0xB1));
+    return _mm_cvtsi128_si32(folded);
+}
+
+__attribute__((target("sse4.1"))) static void addSse41(
+    int16_t *values, const int16_t *weights) {
+    __m128i *v = reinterpret_cast<__m128i *>(values);
+    const __m128i *w = reinterpret_cast<const __m128i *>(weights);
+    for (int i = 0; i < NNUE_HIDDEN / 8; i++)
+        v[i] = _mm_add_epi16(v[i], w[i]);
+}
+
+__attribute__((target("sse4.1"))) static void subtractSse41(
+    int16_t *values, const int16_t *weights) {
+    __m128i *v = reinterpret_cast<__m128i *>(values);
+    const __m128i *w = reinterpret_cast<const __m128i *>(weights);
+    for (int i = 0; i < NNUE_HIDDEN / 8; i++)
+        v[i] = _mm_sub_epi16(v[i], w[i]);
+}
+
+__attribute__((target("sse4.1"))) static int32_t outputSse41(
+    const int16_t *us, const int16_t *them, const int16_t *weights) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i clip = _mm_set1_epi16(CLIP);
+    const int16_t *halves[2] = {us, them};
+
+    __m128i sum = _mm_setzero_si128();
+    for (int half = 0; half < 2; half++) {
+        const __m128i *v = reinterpret_cast<const __m128i *>(halves[half]);
+        const __m128i *w =
+            reinterpret_cast<const __m128i *>(weights + half * NNUE_HIDDEN);
+        for (int i = 0; i < NNUE_HIDDEN / 8; i++) {
+            const __m128i clipped =
+                _mm_min_epi16(_mm_max_epi16(v[i], zero), clip);
+            sum = _mm_add_epi32(sum, _mm_madd_epi16(clipped, w[i]));
+        }
+    }
+
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0x4E));
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0xB1));
+    return _mm_cvtsi128_si32(sum);
+}
+
+static bool hasAvx2() { return __builtin_cpu_supports("avx2"); }
+static bool hasSse41() { return __builtin_cpu_supports("sse4.1"); }
+#endif
+
+static bool always() { return true; }
+
+struct Kernel {
+    const char *name;
+    bool (*supported)();
+    void (*add)(int16_t *, const int16_t *);
+    void (*subtract)(int16_t *, const int16_t *);
+    int32_t (*output)(const int16_t *, const int16_t *, const int16_t *);
+};
+
+// best first; the scalar kernel runs anywhere
+static const Kernel kernels[] = {
+#ifdef NNUE_X86
+    {"avx2", hasAvx2, addAvx2, subtractAvx2, outputAvx2},
+    {"sse4.1", hasSse41, addSse41, subtractSse41, outputSse41},
+#endif
+    {"scalar", always, addScalar, subtractScalar, outputScalar},
+};
+const int KERNEL_COUNT = sizeof(kernels) / sizeof(kernels[0]);
+
+static const Kernel *kernel = NULL;
+
+static const Kernel *available(int index) {
+    int seen = 0;
+    for (const Kernel &k : kernels)
+        if (k.supported() && seen++ == index) return &k;
+    return NULL;
+}
+
+int nnueKernelCount() {
+    int count = 0;
+    while (available(count)) count++;
+    return count;
+}
+
+const char *nnueKernelName(int index) {
+    const Kernel *k = available(index);
+    return k ? k->name : NULL;
+}
+
+const char *nnueKernel() { return kernel ? kernel->name : "none"; }
+
+bool selectNnueKernel(const char *name) {
+    for (int i = 0; available(i); i++)
+        if (!strcmp(available(i)->name, name)) {
+            kernel = available(i);
+            return true;
+        }
+    return false;
+}
+
+bool loadNetwork(const char *path) {
+    FILE *file = fopen(path, "rb");
+    if (!file) return false;
+
+    // read into a scratch copy so a bad file leaves the current network
+    std::unique_ptr<Network> read(new Network);
+    uint32_t header[2];
+    const bool ok =
+        fread(header, sizeof(header), 1, file) == 1 &&
+        header[0] == NNUE_MAGIC && header[1] == uint32_t(NNUE_HIDDEN) &&
+        fread(read->featureWeights, sizeof(read->featureWeights), 1, file) ==
+            1 &&
+        fread(read->featureBias, sizeof(read->featureBias), 1, file) == 1 &&
+        fread(read->outputWeights, sizeof(read->outputWeights), 1, file) ==
+            1 &&
+        fread(&read->outputBias, sizeof(read->outputBias), 1, file) == 1;
+    fclose(file);
+    if (!ok) return false;
+    for (int16_t weight : read->outputWeights)
+        if (weight < -MAX_OUTPUT_WEIGHT || weight > MAX_OUTPUT_WEIGHT)
+            return false;
+    if (read->outputBias < -MAX_OUTPUT_BIAS ||
+        read->outputBias > MAX_OUTPUT_BIAS)
+        return false;
+
+    network = *read;
+    if (!kernel) kernel = available(0);
+    loaded = true;
+    return true;
+}
+
+bool writeSeedNetwork(const char *path) {
+    // neuron 0 sums the perspective's own pieces and neuron 1 the enemy's,
+    // each in units of OUTPUT_SCALE centipawns
+    initPsqt();
+    std::unique_ptr<Network> seed(new Network());
+    for (int type = tPawn; type <= tQueen; type++)
+        for (int sq = 0; sq < 64; sq++) {
+            const int own = mgValue(pieceSquare[White][type][sq]);
+            const int enemy = -mgValue(pieceSquare[Black][type][sq]);
+            seed->featureWeights[type * 64 + sq][0] =
+                (own + OUTPUT_SCALE / 2) / OUTPUT_SCALE;
+            seed->featureWeights[384 + type * 64 + sq][1] =
+                (enemy + OUTPUT_SCALE / 2) / OUTPUT_SCALE;
+        }
+    seed->outputWeights[0] = OUTPUT_SCALE * OUTPUT_SCALE;
+    seed->outputWeights[1] = -OUTPUT_SCALE * OUTPUT_SCALE;
+
+    FILE *file = fopen(path, "wb");
+    if (!file) return false;
+    const uint32_t header[2] = {NNUE_MAGIC, uint32_t(NNUE_HIDDEN)};
+    const bool ok =
+        fwrite(header, sizeof(header), 1, file) == 1 &&
+        fwrite(seed->featureWeights, sizeof(seed->featureWeights), 1,
+               file) == 1 &&
+        fwrite(seed->featureBias, sizeof(seed->featureBias), 1, file) == 1 &&
+        fwrite(seed->outputWeights, sizeof(seed->outputWeights), 1, file) ==
+            1 &&
+        fwrite(&seed->outputBias, sizeof(seed->outputBias), 1, file) == 1;
+    return fclose(file) == 0 && ok;
+}
+
+bool networkLoaded() { return loaded; }
+void setNnueEnabled(bool on) { enabled = on; }
+bool nnueEnabled() { return loaded && enabled; }
+
+void refreshAccumulator(Accumulator &accumulator,
+                        const Bitboard pieces[2][6]) {
+    for (Color perspective : {Black, White}) {
+        int16_t *values = accumulator.values[perspective];
+        memcpy(values, network.featureBias, sizeof(network.featureBias));
+        for (Color color : {Black, White})
+            for (int type = tPawn; type <= tQueen; type++)
+                for (Bitboard b = pieces[color][type]; b;) {
+                    const int feature = featureIndex(perspective, color,
+                                                     Type(type), popLsb(b));
+                    kernel->add(values, network.featureWeights[feature]);
+                }
+    }
+}
+
+void addFeature(Accumulator &accumulator, Color color, Type type, int sq) {
+    for (Color perspective : {Black, White})
+        kernel->add(accumulator.values[perspective],
+                    network.featureWeights[featureIndex(perspective, color,
+                                                        type, sq)]);
+}
+
+void removeFeature(Accumulator &accumulator, Color color, Type type,
+                   int sq) {
+    for (Color perspective : {Black, White})
+        kernel->subtract(accumulator.values[perspective],
+                         network.featureWeights[featureIndex(perspective,
+                                                             color, type, sq)]);
+}
+
+int evaluateNnue(const Accumulator &accumulator, Color sideToMove) {
+    const int32_t sum =
+        network.outputBias +
+        kernel->output(accumulator.values[sideToMove],
+                       accumulator.values[sideToMove == White ? Black : White],
+                       network.outputWeights);
+    return sum / OUTPUT_SCALE;
+}
+
+int nnueCommand(int argc, char **argv) {
+    if (argc != 2 || strcmp(argv[0], "seed")) {
+        std::cout << "usage: chess nnue seed <file>" << std::endl;
+        return 1;
+    }
+    if (!writeSeedNetwork(argv[1])) {
+        std::cout << "cannot write network: " << argv[1] << std::endl;
+        return 1;
+    }
+    std::cout << "wrote seed network to " << argv[1] << std::endl;
+    return 0;
+}
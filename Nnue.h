@@ -0,0 +1,59 @@
+#ifndef NNUE_H
+#define NNUE_H
+
+#include <cstdint>
+
+#include "Bitboard.h"
+
+enum Color : int;
+enum Type : int;
+
+// An efficiently updatable network over piece-square features: 768 inputs
+// (own/enemy x type x square, mirrored for black) feed NNUE_HIDDEN
+// neurons per perspective, whose clipped outputs for the side to move and
+// the other side feed a single output. The first layer's sums live in an
+// Accumulator that the board updates as pieces come and go.
+const int NNUE_FEATURES = 768;
+const int NNUE_HIDDEN = 256;
+
+struct alignas(64) Accumulator {
+    int16_t values[2][NNUE_HIDDEN];  // indexed by perspective Color
+};
+
+// reads a network file, replacing the current network; false if the file
+// is missing or malformed, or its output weights are too large for the
+// output sum to fit 32 bits, in which case the current network stays
+bool loadNetwork(const char *path);
+
+// writes a network that reproduces the midgame material and piece-square
+// score, for exercising the pipeline before a trained file is available
+bool writeSeedNetwork(const char *path);
+
+bool networkLoaded();
+
+// whether boards should keep accumulators and evaluate with the network;
+// only takes effect once a network is loaded
+void setNnueEnabled(bool);
+bool nnueEnabled();
+
+// the SIMD kernels this CPU can run, best first, and the one in use;
+// the best is chosen when the first network is loaded
+int nnueKernelCount();
+const char *nnueKernelName(int);
+const char *nnueKernel();
+bool selectNnueKernel(const char *name);
+
+// recomputes an accumulator from the board's piece bitboards, or applies
+// one piece appearing or disappearing on a square
+void refreshAccumulator(Accumulator &, const Bitboard pieces[2][6]);
+void addFeature(Accumulator &, Color, Type, int sq);
+void removeFeature(Accumulator &, Color, Type, int sq);
+
+// the network's score in centipawns for the side to move
+int evaluateNnue(const Accumulator &, Color sideToMove);
+
+// "nnue seed <file>": writes the seed network, for loading with --nnue or
+// the EvalFile option
+int nnueCommand(int argc, char **argv);
+
+#endif
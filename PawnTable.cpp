@@ -0,0 +1,22 @@
+#include "PawnTable.h"
+
+PawnTable::PawnTable()
+    : entries(PAWN_TABLE_SIZE), probeCount(0), hitCount(0) {
+    clear();
+}
+
+PawnEntry *PawnTable::probe(uint64_t key) {
+    PawnEntry *entry = &entries[key & (PAWN_TABLE_SIZE - 1)];
+    probeCount++;
+    if (entry->key == key) hitCount++;
+    return entry;
+}
+
+void PawnTable::clear() {
+    for (PawnEntry &entry : entries) entry = PawnEntry();
+}
+
+uint64_t PawnTable::probes() const { return probeCount; }
+uint64_t PawnTable::hits() const { return hitCount; }
+
+void PawnTable::resetStats() { probeCount = hitCount = 0; }
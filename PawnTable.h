@@ -0,0 +1,44 @@
+#ifndef PAWNTABLE_H
+#define PAWNTABLE_H
+
+#include <cstdint>
+#include <vector>
+
+#include "Bitboard.h"
+#include "Psqt.h"
+
+// what the pawns alone decide about a position
+struct PawnEntry {
+    uint64_t key;
+    Score score;             // white's pawn structure terms minus black's
+    Bitboard attackSpan[2];  // indexed by Color
+};
+
+// entries per table, a power of two
+const int PAWN_TABLE_SIZE = 16384;
+
+// cache of pawn structure evaluations keyed by the board's pawn key, one
+// per search thread so it needs no locking. Pawns move rarely, so nearly
+// every probe hits.
+class PawnTable {
+   public:
+    PawnTable();
+
+    // the slot for the key; it holds the key's entry if entry->key == key,
+    // otherwise the caller fills it in. An empty slot holds the correct
+    // entry for positions without pawns.
+    PawnEntry *probe(uint64_t key);
+    void clear();
+
+    // probes and hits since the last resetStats
+    uint64_t probes() const;
+    uint64_t hits() const;
+    void resetStats();
+
+   private:
+    std::vector<PawnEntry> entries;
+    uint64_t probeCount;
+    uint64_t hitCount;
+};
+
+#endif
@@ -0,0 +1,266 @@
+#include "Perft.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+#include "ChessBoard.h"
+#include "ChessMove.h"
+#include "ThreadPool.h"
+
+using std::chrono::steady_clock;
+
+uint64_t perft(ChessBoard &board, int depth) {
+    if (depth == 0) return 1;
+
+    MoveList list;
+    board.generateLegalMoves(list);
+    if (depth == 1) return list.size();
+
+    uint64_t nodes = 0;
+    for (ChessMove move : list) {
+        board.makeMove(move);
+        nodes += perft(board, depth - 1);
+        board.unmakeMove();
+    }
+    return nodes;
+}
+
+static double secondsSince(steady_clock::time_point start) {
+    return std::chrono::duration<double>(steady_clock::now() - start).count();
+}
+
+static void reportSpeed(uint64_t nodes, double seconds, std::ostream &os) {
+    const double nps = seconds > 0 ? nodes / seconds : 0;
+    os << "nodes " << nodes << '\n';
+    os << "time  " << std::fixed << std::setprecision(3) << seconds << " s\n";
+    os << "nps   " << std::setprecision(0) << nps << std::endl;
+}
+
+uint64_t perftDivide(ChessBoard &board, int depth, std::ostream &os) {
+    const steady_clock::time_point start = steady_clock::now();
+
+    MoveList list;
+    board.generateLegalMoves(list);
+
+    uint64_t total = 0;
+    char buf[6];
+    for (ChessMove move : list) {
+        uint64_t nodes = 1;
+        if (depth > 1) {
+            board.makeMove(move);
+            nodes = perft(board, depth - 1);
+            board.unmakeMove();
+        }
+        total += nodes;
+        os << move.str(buf) << ": " << nodes << '\n';
+    }
+
+    os << '\n';
+    reportSpeed(total, secondsSince(start), os);
+    return total;
+}
+
+// the tree is split until every thread has this many tasks to choose from,
+// so that stealing can even out subtrees of very different sizes
+const int TASKS_PER_THREAD = 16;
+const int MAX_SPLIT_PLY = 4;
+
+struct PerftTask {
+    int root;
+    int length;
+    ChessMove path[MAX_SPLIT_PLY];
+};
+
+struct PerftWorker {
+    ChessBoard board;
+    uint64_t nodes;
+    double busy;
+    std::vector<uint64_t> roots;
+};
+
+static std::vector<PerftTask> splitTree(ChessBoard &board,
+                                        const MoveList &roots, int depth,
+                                        int threads) {
+    std::vector<PerftTask> tasks;
+    for (int i = 0; i < roots.size(); i++) {
+        PerftTask task = {i, 1, {roots[i]}};
+        tasks.push_back(task);
+    }
+
+    // keep at least two plies below every task so none of them is trivial
+    int length = 1;
+    while (int(tasks.size()) < threads * TASKS_PER_THREAD &&
+           length < MAX_SPLIT_PLY && depth - length > 2) {
+        std::vector<PerftTask> deeper;
+        for (const PerftTask &task : tasks) {
+            for (int i = 0; i < task.length; i++) board.makeMove(task.path[i]);
+
+            MoveList list;
+            board.generateLegalMoves(list);
+            for (ChessMove move : list) {
+                PerftTask child = task;
+                child.path[child.length++] = move;
+                deeper.push_back(child);
+            }
+
+            for (int i = 0; i < task.length; i++) board.unmakeMove();
+        }
+        tasks.swap(deeper);
+        length++;
+    }
+
+    return tasks;
+}
+
+uint64_t perftParallel(const ChessBoard &root, int depth, int threads,
+                       std::ostream &os) {
+    const steady_clock::time_point start = steady_clock::now();
+
+    ChessBoard board(root);
+    MoveList roots;
+    board.generateLegalMoves(roots);
+
+    std::vector<PerftTask> tasks = splitTree(board, roots, depth, threads);
+
+    ThreadPool pool(threads);
+    std::vector<PerftWorker> workers(pool.size(),
+                                     PerftWorker{root, 0, 0, {}});
+    for (PerftWorker &worker : workers) worker.roots.assign(roots.size(), 0);
+
+    for (const PerftTask &task : tasks) {
+        pool.submit([&workers, &task, depth](int id) {
+            const steady_clock::time_point begin = steady_clock::now();
+            PerftWorker &worker = workers[id];
+
+            for (int i = 0; i < task.length; i++)
+                worker.board.makeMove(task.path[i]);
+            const uint64_t nodes = perft(worker.board, depth - task.length);
+            for (int i = 0; i < task.length; i++) worker.board.unmakeMove();
+
+            worker.nodes += nodes;
+            worker.roots[task.root] += nodes;
+            worker.busy += secondsSince(begin);
+        });
+    }
+    pool.wait();
+
+    uint64_t total = 0;
+    char buf[6];
+    for (int i = 0; i < roots.size(); i++) {
+        uint64_t nodes = 0;
+        for (const PerftWorker &worker : workers) nodes += worker.roots[i];
+        total += nodes;
+        os << roots[i].str(buf) << ": " << nodes << '\n';
+    }
+
+    os << '\n';
+    const double seconds = secondsSince(start);
+    reportSpeed(total, seconds, os);
+
+    os << "tasks " << tasks.size() << '\n';
+    for (int i = 0; i < int(workers.size()); i++) {
+        const PerftWorker &worker = workers[i];
+        os << "thread " << i << ": " << worker.nodes << " nodes, "
+           << std::setprecision(0)
+           << (worker.busy > 0 ? worker.nodes / worker.busy : 0) << " nps, "
+           << std::setprecision(1)
+           << (seconds > 0 ? 100 * worker.busy / seconds : 0) << "% busy\n";
+    }
+    os << std::flush;
+
+    return total;
+}
+
+struct PerftPosition {
+    const char *fen;
+    uint64_t nodes[6];
+};
+
+// published counts for depths 1 to 6 (0 where not listed)
+static const PerftPosition perftPositions[] = {
+    {"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+     {20, 400, 8902, 197281, 4865609, 119060324}},
+    {"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+     {48, 2039, 97862, 4085603, 193690690, 8031647685ULL}},
+    {"8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+     {14, 191, 2812, 43238, 674624, 11030083}},
+    {"r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+     {6, 264, 9467, 422333, 15833292, 706045033}},
+    {"rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+     {44, 1486, 62379, 2103487, 89941194, 0}},
+    {"r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+     {46, 2079, 89890, 3894594, 164075551, 6923051137ULL}},
+};
+
+bool perftSuite(int maxDepth, std::ostream &os) {
+    ChessBoard board;
+    bool passed = true;
+    uint64_t total = 0;
+    const steady_clock::time_point start = steady_clock::now();
+
+    for (const PerftPosition &position : perftPositions) {
+        board.setFen(position.fen);
+        os << position.fen << '\n';
+
+        for (int depth = 1; depth <= maxDepth && depth <= 6; depth++) {
+            const uint64_t expected = position.nodes[depth - 1];
+            if (!expected) break;
+
+            const uint64_t nodes = perft(board, depth);
+            total += nodes;
+            os << "  depth " << depth << ": " << nodes;
+            if (nodes == expected) {
+                os << " ok\n";
+            } else {
+                os << " FAILED, expected " << expected << '\n';
+                passed = false;
+            }
+        }
+    }
+
+    os << '\n';
+    reportSpeed(total, secondsSince(start), os);
+    os << (passed ? "all counts match" : "some counts differ") << std::endl;
+    return passed;
+}
+
+int perftCommand(int argc, char **argv) {
+    if (argc > 0 && !strcmp(argv[0], "suite")) {
+        const int depth = argc > 1 ? atoi(argv[1]) : 4;
+        return perftSuite(depth, std::cout) ? 0 : 1;
+    }
+
+    int threads = 1;
+    const char *positional[2] = {NULL, NULL};
+    int count = 0;
+    for (int i = 0; i < argc; i++) {
+        if ((!strcmp(argv[i], "-t") || !strcmp(argv[i], "--threads")) &&
+            i + 1 < argc)
+            threads = atoi(argv[++i]);
+        else if (count < 2)
+            positional[count++] = argv[i];
+    }
+
+    const int depth = positional[0] ? atoi(positional[0]) : 0;
+    if (depth < 1 || threads < 1) {
+        std::cout << "usage: chess perft <depth> [fen] [--threads n]\n"
+                  << "       chess perft suite [depth]" << std::endl;
+        return 1;
+    }
+
+    ChessBoard board;
+    if (positional[1] && !board.setFen(positional[1])) {
+        std::cout << "invalid fen: " << positional[1] << std::endl;
+        return 1;
+    }
+
+    if (threads > 1 && depth > 1)
+        perftParallel(board, depth, threads, std::cout);
+    else
+        perftDivide(board, depth, std::cout);
+    return 0;
+}
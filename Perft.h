@@ -0,0 +1,32 @@
+#ifndef PERFT_H
+#define PERFT_H
+
+#include <cstdint>
+#include <iosfwd>
+
+class ChessBoard;
+
+// counts the leaf nodes of the legal move tree to the given depth; the last
+// ply is counted from the move list without being played
+uint64_t perft(ChessBoard &, int depth);
+
+// prints the node count below each root move, the total, nodes per second
+// and wall time; returns the total
+uint64_t perftDivide(ChessBoard &, int depth, std::ostream &);
+
+// perftDivide spread over a work-stealing pool: the tree is split at the
+// root and, while there are too few tasks to keep every thread busy, at
+// deeper plies; each worker plays its tasks on its own copy of the board.
+// Also prints the node rate of every thread.
+uint64_t perftParallel(const ChessBoard &, int depth, int threads,
+                       std::ostream &);
+
+// checks the standard perft positions against their published counts up
+// to the given depth; returns whether every count matched
+bool perftSuite(int maxDepth, std::ostream &);
+
+// entry point for "chess perft <depth> [fen] [--threads n]" and
+// "chess perft suite [depth]"
+int perftCommand(int argc, char **argv);
+
+#endif
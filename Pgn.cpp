@@ -0,0 +1,374 @@
+#include "Pgn.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "ThreadPool.h"
+
+using std::chrono::steady_clock;
+
+// games replayed between releases of the archive, bounding the memory
+// held by a batch whatever the archive's size
+const int BATCH_GAMES = 8192;
+const int GAMES_PER_TASK = 64;
+
+// the piece a SAN letter names, or -1
+static int sanPiece(char c) {
+    switch (c) {
+        case 'N':
+            return tKnight;
+        case 'B':
+            return tBishop;
+        case 'R':
+            return tRook;
+        case 'Q':
+            return tQueen;
+        case 'K':
+            return tKing;
+        default:
+            return -1;
+    }
+}
+
+// the piece each promotion flag makes, by its low two bits
+static const int PROMOTED[4] = {tKnight, tBishop, tRook, tQueen};
+
+static bool isFile(char c) { return c >= 'a' && c <= 'h'; }
+static bool isRank(char c) { return c >= '1' && c <= '8'; }
+
+ChessMove parseSan(const ChessBoard &board, std::string_view san) {
+    while (!san.empty() && strchr("+#!?", san.back()))
+        san.remove_suffix(1);
+
+    MoveList moves;
+    board.generateMoves(moves);
+
+    if (san == "O-O" || san == "0-0" || san == "O-O-O" || san == "0-0-0") {
+        const int flag = san.size() == 3 ? KingCastle : QueenCastle;
+        for (ChessMove move : moves)
+            if (move.flag() == flag && board.isLegal(move)) return move;
+        return ChessMove();
+    }
+
+    // the piece, or a pawn
+    int type = tPawn;
+    if (!san.empty() && sanPiece(san[0]) >= 0) {
+        type = sanPiece(san[0]);
+        san.remove_prefix(1);
+    }
+
+    // the promotion, with or without its "="
+    int promotion = -1;
+    if (type == tPawn && !san.empty() && sanPiece(san.back()) >= 0) {
+        promotion = sanPiece(san.back());
+        san.remove_suffix(1);
+        if (!san.empty() && san.back() == '=') san.remove_suffix(1);
+        if (promotion == tKing) return ChessMove();
+    }
+
+    // the destination last, and before it any of origin file, origin rank
+    // and capture mark
+    if (san.size() < 2 || !isFile(san[san.size() - 2]) || !isRank(san.back()))
+        return ChessMove();
+    const int to = square('8' - san.back(), san[san.size() - 2] - 'a');
+    san.remove_suffix(2);
+    if (!san.empty() && san.back() == 'x') san.remove_suffix(1);
+
+    int file = -1, rank = -1;
+    if (!san.empty() && isFile(san[0])) {
+        file = san[0] - 'a';
+        san.remove_prefix(1);
+    }
+    if (!san.empty() && isRank(san[0])) {
+        rank = '8' - san[0];
+        san.remove_prefix(1);
+    }
+    if (!san.empty()) return ChessMove();
+
+    const Bitboard movers = board.occupancy(board.activeColor, Type(type));
+    ChessMove found;
+    for (ChessMove move : moves) {
+        if (move.to() != to || !(movers & squareBB(move.from())) ||
+            move.isCastle())
+            continue;
+        if (file >= 0 && fileOf(move.from()) != file) continue;
+        if (rank >= 0 && rankOf(move.from()) != rank) continue;
+        if (move.isPromotion() != (promotion >= 0) ||
+            (move.isPromotion() && PROMOTED[move.flag() & 3] != promotion))
+            continue;
+        if (!board.isLegal(move)) continue;
+        // two candidates left: the move needed more disambiguation
+        if (!found.isNull()) return ChessMove();
+        found = move;
+    }
+    return found;
+}
+
+PgnFile::PgnFile(const char *path)
+    : data(NULL), length(0), offset(0), released(0), line(1) {
+    const int fd = open(path, O_RDONLY);
+    if (fd < 0) return;
+
+    struct stat info;
+    if (fstat(fd, &info) == 0 && info.st_size > 0) {
+        void *map = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (map != MAP_FAILED) {
+            madvise(map, info.st_size, MADV_SEQUENTIAL);
+            data = static_cast<const char *>(map);
+            length = info.st_size;
+        }
+    }
+    // the mapping outlives the descriptor
+    close(fd);
+}
+
+PgnFile::~PgnFile() {
+    if (data) munmap(const_cast<char *>(data), length);
+}
+
+bool PgnFile::isOpen() const { return data != NULL; }
+size_t PgnFile::size() const { return length; }
+
+bool PgnFile::nextGame(PgnGame &game) {
+    // blank lines between games
+    while (offset < length && isspace(static_cast<unsigned char>(
+                                  data[offset]))) {
+        if (data[offset] == '\n') line++;
+        offset++;
+    }
+    if (offset == length) return false;
+
+    const size_t start = offset;
+    game.line = line;
+    bool movetext = false;
+    while (offset < length) {
+        const char *end = static_cast<const char *>(
+            memchr(data + offset, '\n', length - offset));
+        const size_t next = end ? end - data + 1 : length;
+
+        size_t first = offset;
+        while (first < next && (data[first] == ' ' || data[first] == '\t'))
+            first++;
+        // a tag after the movetext begins the next game
+        if (first < next && data[first] == '[') {
+            if (movetext) break;
+        } else if (first < next && !isspace(static_cast<unsigned char>(
+                                       data[first]))) {
+            movetext = true;
+        }
+        offset = next;
+        line++;
+    }
+    game.text = std::string_view(data + start, offset - start);
+    return true;
+}
+
+void PgnFile::release() {
+    static const size_t page = sysconf(_SC_PAGESIZE);
+    const size_t upTo = offset / page * page;
+    if (upTo <= released) return;
+    madvise(const_cast<char *>(data) + released, upTo - released,
+            MADV_DONTNEED);
+    released = upTo;
+}
+
+// the value of a tag line such as [FEN "..."], if it is the named tag
+static bool tagValue(std::string_view tag, std::string_view name,
+                     std::string_view &value) {
+    size_t i = 1;
+    while (i < tag.size() && tag[i] == ' ') i++;
+    if (tag.substr(i, name.size()) != name) return false;
+    i += name.size();
+    while (i < tag.size() && tag[i] == ' ') i++;
+    if (i == tag.size() || tag[i] != '"') return false;
+
+    const size_t end = tag.find('"', i + 1);
+    if (end == std::string_view::npos) return false;
+    value = tag.substr(i + 1, end - i - 1);
+    return true;
+}
+
+PgnResult replayGame(ChessBoard &board, std::string_view game,
+                     const PgnVisitor &visit) {
+    PgnResult result = {0, -1, NULL, std::string_view()};
+    board.resetBoard();
+    // moves made since the board's history was last cleared
+    int plies = 0;
+    // cleared by the visitor; what follows is only read for the result
+    bool playing = true;
+
+    size_t i = 0;
+    while (i < game.size()) {
+        const char c = game[i];
+        if (isspace(static_cast<unsigned char>(c))) {
+            i++;
+        } else if (c == '[') {
+            size_t end = game.find('\n', i);
+            if (end == std::string_view::npos) end = game.size();
+            std::string_view fen;
+            if (tagValue(game.substr(i, end - i), "FEN", fen) &&
+                !board.setFen(fen)) {
+                result.error = "bad FEN";
+                result.move = fen;
+                return result;
+            }
+            i = end;
+        } else if (c == '{') {
+            const size_t end = game.find('}', i);
+            i = end == std::string_view::npos ? game.size() : end + 1;
+        } else if (c == ';' || c == '%') {
+            const size_t end = game.find('\n', i);
+            i = end == std::string_view::npos ? game.size() : end + 1;
+        } else if (c == '(') {
+            // variations nest, and may hold comments with parentheses
+            int depth = 0;
+            for (; i < game.size(); i++) {
+                if (game[i] == '{') {
+                    const size_t end = game.find('}', i);
+                    if (end == std::string_view::npos) break;
+                    i = end;
+                } else if (game[i] == '(') {
+                    depth++;
+                } else if (game[i] == ')' && --depth == 0) {
+                    i++;
+                    break;
+                }
+            }
+        } else {
+            size_t end = i;
+            while (end < game.size() &&
+                   !isspace(static_cast<unsigned char>(game[end])) &&
+                   !strchr("{}();[", game[end]))
+                end++;
+            std::string_view token = game.substr(i, end - i);
+            i = std::max(end, i + 1);
+            // a stray ')' or '}' stops the scan before taking anything
+            if (token.empty()) continue;
+
+            if (token == "1-0" || token == "0-1" || token == "1/2-1/2" ||
+                token == "*") {
+                if (token != "*")
+                    result.score = token == "1-0" ? 2 : token == "0-1" ? 0 : 1;
+                break;
+            }
+            if (token[0] == '$') continue;
+            // a move number, perhaps run into its move as in "1.e4"
+            if (isdigit(static_cast<unsigned char>(token[0])) &&
+                token.find('.') != std::string_view::npos)
+                token.remove_prefix(token.find('.'));
+            while (!token.empty() && token[0] == '.') token.remove_prefix(1);
+            if (token.empty() || !playing) continue;
+
+            const ChessMove move = parseSan(board, token);
+            if (move.isNull()) {
+                result.error = "illegal or ambiguous move";
+                result.move = token;
+                return result;
+            }
+            if (visit && !visit(board, move)) {
+                playing = false;
+                continue;
+            }
+            // long games outgrow the history; only repetitions are lost
+            if (++plies == MAX_GAME_PLY) {
+                PackedPosition packed;
+                board.pack(packed);
+                board.unpack(packed);
+                plies = 1;
+            }
+            board.makeMove(move);
+            result.moves++;
+        }
+    }
+    return result;
+}
+
+bool replayPgn(const char *path, int threads, std::ostream &os) {
+    const steady_clock::time_point start = steady_clock::now();
+    PgnFile file(path);
+    if (!file.isOpen()) {
+        os << "cannot read " << path << std::endl;
+        return false;
+    }
+
+    ThreadPool pool(threads);
+    std::vector<ChessBoard> boards(pool.size());
+    for (ChessBoard &board : boards) board.setOutput(NULL);
+
+    std::vector<PgnGame> games;
+    std::vector<PgnResult> results;
+    games.reserve(BATCH_GAMES);
+    uint64_t played = 0, moves = 0, failed = 0;
+    for (bool more = true; more;) {
+        games.clear();
+        PgnGame game;
+        while (int(games.size()) < BATCH_GAMES &&
+               (more = file.nextGame(game)))
+            games.push_back(game);
+
+        results.resize(games.size());
+        for (size_t begin = 0; begin < games.size(); begin += GAMES_PER_TASK) {
+            const size_t end =
+                std::min(begin + GAMES_PER_TASK, games.size());
+            pool.submit([&boards, &games, &results, begin, end](int id) {
+                for (size_t i = begin; i < end; i++)
+                    results[i] = replayGame(boards[id], games[i].text);
+            });
+        }
+        pool.wait();
+
+        for (size_t i = 0; i < games.size(); i++) {
+            moves += results[i].moves;
+            if (results[i].error) {
+                failed++;
+                os << "game " << played + i + 1 << " at line "
+                   << games[i].line << ": " << results[i].error << " \""
+                   << results[i].move << "\" after " << results[i].moves
+                   << " plies\n";
+            }
+        }
+        played += games.size();
+        file.release();
+    }
+
+    const double seconds =
+        std::chrono::duration<double>(steady_clock::now() - start).count();
+    os << "games     " << played << '\n'
+       << "failed    " << failed << '\n'
+       << "moves     " << moves << '\n'
+       << "time      " << std::fixed << std::setprecision(3) << seconds
+       << " s on " << pool.size() << " threads\n"
+       << "rate      " << std::setprecision(0)
+       << (seconds > 0 ? played / seconds : 0) << " games/s, "
+       << (seconds > 0 ? moves / seconds : 0) << " moves/s" << std::endl;
+    return failed == 0;
+}
+
+int pgnCommand(int argc, char **argv) {
+    const char *path = NULL;
+    int threads = int(std::max(1u, std::thread::hardware_concurrency()));
+    for (int i = 0; i < argc; i++) {
+        if (!strcmp(argv[i], "--threads") && i + 1 < argc)
+            threads = std::max(1, atoi(argv[++i]));
+        else
+            path = argv[i];
+    }
+
+    if (!path) {
+        std::cout << "usage: chess pgn <file> [--threads n]" << std::endl;
+        return 1;
+    }
+    return replayPgn(path, threads, std::cout) ? 0 : 1;
+}
@@ -0,0 +1,83 @@
+#ifndef PGN_H
+#define PGN_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iosfwd>
+#include <string_view>
+
+#include "ChessBoard.h"
+#include "ChessMove.h"
+
+// the legal move written in standard algebraic notation ("Nbd7", "exd6",
+// "e8=Q+", "O-O"), or a null move if there is none or it is ambiguous.
+// Check marks and annotations are ignored, as are a missing "=" before a
+// promoted piece and zeros for castling.
+ChessMove parseSan(const ChessBoard &, std::string_view);
+
+// one game of an archive: its text, tags and movetext, viewing the file,
+// and the line it starts on
+struct PgnGame {
+    std::string_view text;
+    uint64_t line;
+};
+
+// a read-only memory-mapped PGN archive split into games as it is walked.
+// Only what lies ahead of release() stays mapped in memory, so walking an
+// archive of any size takes little more than the games being looked at.
+class PgnFile {
+   public:
+    explicit PgnFile(const char *path);
+    PgnFile(const PgnFile &) = delete;
+    PgnFile &operator=(const PgnFile &) = delete;
+    ~PgnFile();
+
+    bool isOpen() const;
+    size_t size() const;
+
+    // the next game, from its first tag to just before the next game's;
+    // false at the end
+    bool nextGame(PgnGame &);
+    // lets the pages before the next game go; views into them must no
+    // longer be used
+    void release();
+
+   private:
+    const char *data;
+    size_t length;
+    size_t offset;
+    size_t released;
+    uint64_t line;
+};
+
+// how replaying one game went
+struct PgnResult {
+    int moves;
+    // the result the movetext ends with, from white's side in half points:
+    // 2 for a win, 1 for a draw, 0 for a loss, or -1 if it has none
+    int score;
+    // why the game could not be replayed, or NULL; the move is the one
+    // that failed, viewing the game
+    const char *error;
+    std::string_view move;
+};
+
+// sees each move of a game replayed, on the board before it is made;
+// returning false plays no further moves, though the result is still read
+typedef std::function<bool(const ChessBoard &, ChessMove)> PgnVisitor;
+
+// plays every move of the game on the board, from the FEN tag if it has
+// one, through the legality checks of the move generator
+PgnResult replayGame(ChessBoard &, std::string_view game,
+                     const PgnVisitor & = PgnVisitor());
+
+// replays every game of the archive on the given number of threads,
+// reporting each game that failed and then games and moves per second;
+// false if any game failed
+bool replayPgn(const char *path, int threads, std::ostream &);
+
+// entry point for "chess pgn <file> [--threads n]"
+int pgnCommand(int argc, char **argv);
+
+#endif
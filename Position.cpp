@@ -3,8 +3,6 @@
 #include <iostream>
 #include "Position.h"
 
-int Position::rank() const { return r; }
-int Position::file() const { return f; }
 const char *Position::str() const { return s; }
 
 bool Position::validPosition(int _rank, int _file) {
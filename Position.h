@@ -11,7 +11,7 @@ const int basicMoves[8][2] = {
 };
 
 const int knightMoves[8][2] = {
-  { 1, 2 }, {-1, 2}, {2, -1}, {2, 1}, {1, -2}, {-1, -2}, {2, 1}, {2, -1}
+  { 1, 2 }, {-1, 2}, {2, -1}, {2, 1}, {1, -2}, {-1, -2}, {-2, 1}, {-2, -1}
 };
 
 class Position {
@@ -38,4 +38,7 @@ public:
   bool operator!=(Position const &pos);  
 };
 
+inline int Position::rank() const { return r; }
+inline int Position::file() const { return f; }
+
 #endif
@@ -0,0 +1,106 @@
+#include "Psqt.h"
+
+#include "Bitboard.h"
+#include "ChessPiece.h"
+
+Score pieceSquare[2][6][64];
+
+const int phaseWeight[6] = {0, 2, 1, 1, 0, 4};
+const int mgPieceValue[6] = {82, 477, 337, 365, 0, 1025};
+const int egPieceValue[6] = {94, 512, 281, 297, 0, 936};
+
+#define S(mg, eg) makeScore(mg, eg)
+
+// bonuses for the queen side half of the board from white's point of view,
+// rank 1 first; the king side mirrors them
+static const Score bonus[6][8][4] = {
+    {
+        // pawn
+        {S(0, 0), S(0, 0), S(0, 0), S(0, 0)},
+        {S(0, 0), S(5, 0), S(5, 0), S(-10, 0)},
+        {S(0, 0), S(0, 0), S(5, 0), S(10, 0)},
+        {S(-5, 5), S(0, 5), S(10, 5), S(20, 5)},
+        {S(0, 15), S(5, 15), S(10, 15), S(20, 15)},
+        {S(5, 40), S(10, 40), S(15, 40), S(20, 40)},
+        {S(20, 90), S(25, 90), S(30, 90), S(30, 90)},
+        {S(0, 0), S(0, 0), S(0, 0), S(0, 0)},
+    },
+    {
+        // rook
+        {S(-5, -5), S(-5, -3), S(0, -2), S(5, 0)},
+        {S(-10, -5), S(-5, -3), S(-3, -2), S(0, 0)},
+        {S(-8, -3), S(-3, -2), S(-2, 0), S(0, 0)},
+        {S(-8, -3), S(-3, -2), S(-2, 0), S(0, 0)},
+        {S(-8, -3), S(-3, -2), S(-2, 0), S(0, 0)},
+        {S(-8, -3), S(-3, -2), S(-2, 0), S(0, 0)},
+        {S(10, 5), S(15, 8), S(15, 8), S(15, 8)},
+        {S(5, 5), S(5, 5), S(5, 5), S(5, 5)},
+    },
+    {
+        // knight
+        {S(-80, -60), S(-40, -45), S(-30, -30), S(-25, -20)},
+        {S(-40, -40), S(-20, -25), S(0, -10), S(5, 0)},
+        {S(-30, -30), S(5, -10), S(10, 0), S(15, 10)},
+        {S(-25, -20), S(5, 0), S(20, 10), S(25, 20)},
+        {S(-25, -20), S(10, 0), S(25, 10), S(30, 20)},
+        {S(-30, -30), S(5, -10), S(25, 0), S(25, 10)},
+        {S(-40, -40), S(-20, -25), S(0, -10), S(5, 0)},
+        {S(-90, -60), S(-50, -45), S(-35, -30), S(-30, -20)},
+    },
+    {
+        // bishop
+        {S(-20, -20), S(-10, -10), S(-12, -10), S(-10, -5)},
+        {S(-5, -10), S(10, -5), S(5, 0), S(5, 0)},
+        {S(-5, -5), S(10, 0), S(10, 5), S(10, 5)},
+        {S(-5, -5), S(5, 0), S(15, 5), S(15, 10)},
+        {S(-5, -5), S(10, 0), S(10, 5), S(15, 10)},
+        {S(-10, -5), S(5, 0), S(10, 5), S(10, 5)},
+        {S(-10, -10), S(0, -5), S(0, 0), S(0, 0)},
+        {S(-20, -20), S(-10, -10), S(-10, -10), S(-10, -5)},
+    },
+    {
+        // king
+        {S(30, -50), S(40, -30), S(10, -20), S(-10, -15)},
+        {S(20, -30), S(20, -10), S(-10, 0), S(-20, 5)},
+        {S(-10, -20), S(-20, 0), S(-25, 10), S(-30, 15)},
+        {S(-20, -15), S(-30, 5), S(-35, 15), S(-40, 25)},
+        {S(-30, -15), S(-40, 5), S(-45, 15), S(-50, 25)},
+        {S(-40, -20), S(-50, 0), S(-55, 10), S(-60, 15)},
+        {S(-50, -30), S(-60, -10), S(-60, 0), S(-60, 5)},
+        {S(-60, -50), S(-60, -30), S(-60, -20), S(-60, -15)},
+    },
+    {
+        // queen
+        {S(-10, -25), S(-8, -15), S(-5, -10), S(0, -5)},
+        {S(-8, -15), S(0, -8), S(2, -3), S(2, 0)},
+        {S(-5, -10), S(2, -3), S(3, 3), S(3, 5)},
+        {S(-3, -5), S(2, 0), S(3, 5), S(3, 10)},
+        {S(-3, -5), S(2, 0), S(3, 5), S(3, 10)},
+        {S(-5, -10), S(2, -3), S(3, 3), S(3, 5)},
+        {S(-8, -15), S(0, -8), S(2, -3), S(2, 0)},
+        {S(-10, -25), S(-8, -15), S(-5, -10), S(-5, -5)},
+    },
+};
+
+#undef S
+
+static bool buildTables() {
+    for (int type = tPawn; type <= tQueen; type++)
+        for (int sq = 0; sq < 64; sq++) {
+            // square 0 is a8, so white's rank 1 is row 7
+            const int rank = 7 - rankOf(sq), file = fileOf(sq);
+            const Score score =
+                makeScore(mgPieceValue[type], egPieceValue[type]) +
+                bonus[type][rank][file < 4 ? file : 7 - file];
+
+            // black's square sq ^ 56 is white's sq seen from the other side
+            pieceSquare[White][type][sq] = score;
+            pieceSquare[Black][type][sq ^ 56] = -score;
+        }
+    return true;
+}
+
+void initPsqt() {
+    static const bool built = buildTables();
+    (void)built;
+}
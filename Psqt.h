@@ -0,0 +1,35 @@
+#ifndef PSQT_H
+#define PSQT_H
+
+// a middlegame and an endgame value packed into one int, so that both are
+// added and subtracted together; the endgame half sits in the upper bits
+typedef int Score;
+
+inline Score makeScore(int mg, int eg) {
+    return int(unsigned(eg) << 16) + mg;
+}
+
+inline int mgValue(Score s) { return short(unsigned(s) & 0xFFFF); }
+
+inline int egValue(Score s) {
+    return short((unsigned(s) + 0x8000) >> 16);
+}
+
+// piece values plus piece-square bonuses, indexed by [Color][Type][square]
+// and signed from white's point of view, so a position's score is the sum
+// over its pieces
+extern Score pieceSquare[2][6][64];
+
+// how much each piece type counts towards the middlegame, indexed by Type;
+// the full set of pieces adds up to MAX_PHASE
+extern const int phaseWeight[6];
+const int MAX_PHASE = 24;
+
+// midgame and endgame piece values, indexed by Type
+extern const int mgPieceValue[6];
+extern const int egPieceValue[6];
+
+// fills pieceSquare, safe to call more than once
+void initPsqt();
+
+#endif
@@ -0,0 +1,400 @@
+#include "Server.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <streambuf>
+#include <string>
+#include <thread>
+
+#include "ChessPiece.h"
+
+#ifdef __unix__
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+using std::chrono::steady_clock;
+
+// a batch is cut into tasks of about this many moves, whole games each
+const int MOVES_PER_TASK = 64;
+// and is played once this many moves are waiting, even with more to read
+const int MAX_BATCH = 4096;
+
+static const char *RESULT_NAME[] = {"illegal",   "legal",     "check",
+                                    "checkmate", "stalemate", "unknown"};
+
+GameServer::GameServer(int threads)
+    : liveCount(0), pool(threads), workers(pool.size()) {
+    for (Worker &worker : workers) worker.board.setOutput(NULL);
+}
+
+int GameServer::newGame(std::string_view fen) {
+    ChessBoard &board = workers[0].board;
+    if (fen.empty())
+        board.resetBoard();
+    else if (!board.setFen(fen))
+        return -1;
+
+    int id;
+    if (!freeIds.empty()) {
+        id = freeIds.back();
+        freeIds.pop_back();
+    } else {
+        id = int(games.size());
+        games.push_back(PackedPosition());
+        live.push_back(false);
+    }
+    board.pack(games[id]);
+    live[id] = true;
+    liveCount++;
+    return id;
+}
+
+bool GameServer::endGame(int id) {
+    if (id < 0 || id >= int(games.size()) || !live[id]) return false;
+    live[id] = false;
+    freeIds.push_back(id);
+    liveCount--;
+    return true;
+}
+
+int GameServer::gameCount() const { return liveCount; }
+
+// the move in coordinate notation, if it is legal in the game
+MoveResult GameServer::validate(Worker &worker, MoveRequest &request) {
+    if (request.game < 0 || request.game >= int(games.size()) ||
+        !live[request.game])
+        return UnknownGame;
+
+    ChessBoard &board = worker.board;
+    board.unpack(games[request.game]);
+
+    MoveList moves;
+    board.generateMoves(moves);
+    char buf[6];
+    for (ChessMove move : moves) {
+        if (strcmp(move.str(buf), request.move) || !board.isLegal(move))
+            continue;
+
+        board.makeMove(move);
+        board.pack(games[request.game]);
+        switch (board.status()) {
+            case Check:
+                return GivesCheck;
+            case Checkmate:
+                return GivesMate;
+            case Stalemate:
+                return GivesStalemate;
+            default:
+                return Legal;
+        }
+    }
+    return Illegal;
+}
+
+void GameServer::play(std::vector<MoveRequest> &requests) {
+    // moves grouped by game, keeping their order within each game, so a
+    // game is only ever touched by one task
+    std::vector<int> order(requests.size());
+    for (int i = 0; i < int(order.size()); i++) order[i] = i;
+    std::stable_sort(order.begin(), order.end(), [&](int a, int b) {
+        return requests[a].game < requests[b].game;
+    });
+
+    for (size_t begin = 0; begin < order.size();) {
+        size_t end = std::min(begin + MOVES_PER_TASK, order.size());
+        while (end < order.size() &&
+               requests[order[end]].game == requests[order[end - 1]].game)
+            end++;
+
+        pool.submit([this, &requests, &order, begin, end](int id) {
+            Worker &worker = workers[id];
+            for (size_t i = begin; i < end; i++) {
+                MoveRequest &request = requests[order[i]];
+                const steady_clock::time_point start = steady_clock::now();
+                request.result = validate(worker, request);
+                worker.latencies.push_back(uint32_t(
+                    std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        steady_clock::now() - start)
+                        .count()));
+            }
+        });
+        begin = end;
+    }
+    pool.wait();
+}
+
+void GameServer::reportStats(std::ostream &os) const {
+    std::vector<uint32_t> all;
+    for (const Worker &worker : workers)
+        all.insert(all.end(), worker.latencies.begin(),
+                   worker.latencies.end());
+
+    os << "stats games " << liveCount << " moves " << all.size()
+       << " bytes per game " << sizeof(PackedPosition);
+    if (!all.empty()) {
+        const auto percentile = [&all](int p) {
+            const size_t k = std::min(all.size() - 1, all.size() * p / 100);
+            std::nth_element(all.begin(), all.begin() + k, all.end());
+            return all[k] / 1000.0;
+        };
+        os << std::fixed << std::setprecision(2) << " p50 " << percentile(50)
+           << " us p99 " << percentile(99) << " us";
+    }
+    os << std::endl;
+}
+
+static std::string_view nextToken(std::string_view &line) {
+    const size_t start = line.find_first_not_of(" \t\r");
+    if (start == std::string_view::npos) return line = std::string_view();
+    const size_t end = line.find_first_of(" \t\r", start);
+    const std::string_view token = line.substr(start, end - start);
+    line = end == std::string_view::npos ? std::string_view()
+                                         : line.substr(end);
+    return token;
+}
+
+// a game id in decimal, or -1 for anything else, which names no game
+static int parseId(std::string_view token) {
+    if (token.empty() || token.size() > 9) return -1;
+    int id = 0;
+    for (char c : token) {
+        if (c < '0' || c > '9') return -1;
+        id = id * 10 + c - '0';
+    }
+    return id;
+}
+
+void GameServer::serve(std::istream &is, std::ostream &os) {
+    std::vector<MoveRequest> batch;
+    const auto flush = [&]() {
+        if (batch.empty()) return;
+        play(batch);
+        for (const MoveRequest &request : batch)
+            os << request.game << ' ' << request.move << ' '
+               << RESULT_NAME[request.result] << '\n';
+        os.flush();
+        batch.clear();
+    };
+
+    std::string text;
+    while (std::getline(is, text)) {
+        std::string_view line = text;
+        const std::string_view command = nextToken(line);
+
+        if (command == "move") {
+            const std::string_view game = nextToken(line);
+            const std::string_view move = nextToken(line);
+            MoveRequest request = {parseId(game), "", Illegal};
+            move.substr(0, 5).copy(request.move, 5);
+            request.move[std::min<size_t>(move.size(), 5)] = '\0';
+            batch.push_back(request);
+
+            // keep collecting while the next line is already here
+            if (is.rdbuf()->in_avail() > 0 && int(batch.size()) < MAX_BATCH)
+                continue;
+            flush();
+            continue;
+        }
+
+        flush();
+        if (command == "new") {
+            const size_t start = line.find_first_not_of(" \t\r");
+            const int id = newGame(start == std::string_view::npos
+                                       ? std::string_view()
+                                       : line.substr(start));
+            if (id < 0)
+                os << "error bad fen" << std::endl;
+            else
+                os << "new " << id << std::endl;
+        } else if (command == "end") {
+            const int id = parseId(nextToken(line));
+            if (endGame(id))
+                os << "end " << id << std::endl;
+            else
+                os << "error unknown game" << std::endl;
+        } else if (command == "stats") {
+            reportStats(os);
+        } else if (command == "quit") {
+            return;
+        } else if (!command.empty()) {
+            os << "error unknown command " << command << std::endl;
+        }
+    }
+    flush();
+}
+
+#ifdef __unix__
+// a stream buffer over a connected socket
+class SocketBuffer : public std::streambuf {
+   public:
+    explicit SocketBuffer(int socket) : fd(socket), broken(false) {
+        setg(input, input, input);
+        setp(output, output + sizeof(output));
+    }
+    ~SocketBuffer() { sync(); }
+
+   protected:
+    int_type underflow() override {
+        if (broken) return traits_type::eof();
+        const ssize_t n = read(fd, input, sizeof(input));
+        if (n <= 0) return traits_type::eof();
+        setg(input, input, input + n);
+        return traits_type::to_int_type(*gptr());
+    }
+
+    int_type overflow(int_type c) override {
+        if (sync() < 0) return traits_type::eof();
+        if (!traits_type::eq_int_type(c, traits_type::eof())) sputc(char(c));
+        return traits_type::not_eof(c);
+    }
+
+    // a client that has gone away must not take the server down with
+    // SIGPIPE; the failed send instead ends the session, dropping whatever
+    // was left to write
+    int sync() override {
+        for (char *p = pbase(); p < pptr() && !broken;) {
+            const ssize_t n = send(fd, p, pptr() - p, MSG_NOSIGNAL);
+            if (n <= 0)
+                broken = true;
+            else
+                p += n;
+        }
+        setp(output, output + sizeof(output));
+        return broken ? -1 : 0;
+    }
+
+   private:
+    int fd;
+    bool broken;
+    char input[1 << 16];
+    char output[1 << 16];
+};
+
+// serves one client at a time on a Unix domain socket at path
+static int serveSocket(GameServer &server, const char *path) {
+    const int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    strncpy(address.sun_path, path, sizeof(address.sun_path) - 1);
+    unlink(path);
+    if (listener < 0 ||
+        bind(listener, reinterpret_cast<sockaddr *>(&address),
+             sizeof(address)) < 0 ||
+        listen(listener, 16) < 0) {
+        std::cout << "cannot listen on " << path << std::endl;
+        return 1;
+    }
+
+    std::cout << "listening on " << path << std::endl;
+    for (;;) {
+        const int client = accept(listener, NULL, NULL);
+        if (client < 0) continue;
+        SocketBuffer buffer(client);
+        std::iostream stream(&buffer);
+        server.serve(stream, stream);
+        stream.flush();
+        close(client);
+    }
+}
+#endif
+
+// plays random games in lockstep, one batch per ply across every game, to
+// measure throughput and latency
+static void benchServer(int games, int plies, int threads, std::ostream &os) {
+    // a few distinct random games, replayed by many hosted games each
+    const int SCRIPTS = 64;
+    std::vector<std::vector<std::string>> scripts(SCRIPTS);
+    uint64_t seed = 0x9E3779B97F4A7C15ULL;
+    ChessBoard board;
+    board.setOutput(NULL);
+    char buf[6];
+    for (std::vector<std::string> &script : scripts) {
+        board.resetBoard();
+        for (int ply = 0; ply < plies; ply++) {
+            MoveList moves;
+            board.generateLegalMoves(moves);
+            if (moves.empty()) break;
+            const ChessMove move = moves[random64(seed) % moves.size()];
+            script.push_back(move.str(buf));
+            board.makeMove(move);
+        }
+    }
+
+    GameServer server(threads);
+    for (int i = 0; i < games; i++) server.newGame(std::string_view());
+
+    uint64_t moves = 0, illegal = 0;
+    std::vector<MoveRequest> batch;
+    const steady_clock::time_point start = steady_clock::now();
+    for (int ply = 0; ply < plies; ply++) {
+        batch.clear();
+        for (int game = 0; game < games; game++) {
+            const std::vector<std::string> &script = scripts[game % SCRIPTS];
+            if (ply >= int(script.size())) continue;
+            MoveRequest request = {game, "", Illegal};
+            strcpy(request.move, script[ply].c_str());
+            batch.push_back(request);
+        }
+        if (batch.empty()) break;
+        server.play(batch);
+        moves += batch.size();
+        for (const MoveRequest &request : batch)
+            illegal += request.result == Illegal;
+    }
+    const double seconds =
+        std::chrono::duration<double>(steady_clock::now() - start).count();
+
+    const double rate = seconds > 0 ? moves / seconds : 0;
+    os << games << " games, " << moves << " moves in " << std::fixed
+       << std::setprecision(3) << seconds << " s on " << threads
+       << " threads, " << std::setprecision(0) << rate << " moves/s, "
+       << rate / threads << " moves/s per core"
+       << (illegal ? ", UNEXPECTED ILLEGAL MOVES" : "") << std::endl;
+    // a game moving once every ten seconds, as in a fast online game
+    os << "games per core at one move per 10 s: " << rate * 10 / threads
+       << std::endl;
+    server.reportStats(os);
+}
+
+int serverCommand(int argc, char **argv) {
+    const bool bench = argc > 0 && !strcmp(argv[0], "bench");
+    int threads = int(std::max(1u, std::thread::hardware_concurrency()));
+    const char *socketPath = NULL;
+    std::vector<int> numbers;
+
+    for (int i = bench ? 1 : 0; i < argc; i++) {
+        if (!strcmp(argv[i], "--threads") && i + 1 < argc)
+            threads = std::max(1, atoi(argv[++i]));
+        else if (!strcmp(argv[i], "--socket") && i + 1 < argc)
+            socketPath = argv[++i];
+        else
+            numbers.push_back(atoi(argv[i]));
+    }
+
+    if (bench) {
+        benchServer(numbers.size() > 0 ? std::max(1, numbers[0]) : 10000,
+                    numbers.size() > 1 ? std::max(1, numbers[1]) : 80,
+                    threads, std::cout);
+        return 0;
+    }
+
+    GameServer server(threads);
+    if (socketPath) {
+#ifdef __unix__
+        return serveSocket(server, socketPath);
+#else
+        std::cout << "sockets are not supported here" << std::endl;
+        return 1;
+#endif
+    }
+
+    std::ios::sync_with_stdio(false);
+    server.serve(std::cin, std::cout);
+    return 0;
+}
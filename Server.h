@@ -0,0 +1,86 @@
+#ifndef SERVER_H
+#define SERVER_H
+
+#include <cstdint>
+#include <iosfwd>
+#include <string_view>
+#include <vector>
+
+#include "ChessBoard.h"
+#include "ThreadPool.h"
+
+// what a move sent to a hosted game did; anything but Illegal and
+// UnknownGame was played
+enum MoveResult {
+    Illegal,
+    Legal,
+    GivesCheck,
+    GivesMate,
+    GivesStalemate,
+    UnknownGame
+};
+
+// one move for one game, and once played, what it did
+struct MoveRequest {
+    int game;
+    char move[6];
+    MoveResult result;
+};
+
+// hosts many games at once, each kept only as a PackedPosition. A batch of
+// moves is spread over a thread pool by game: a worker unpacks the game
+// into its own board, validates and plays the move, and packs the game
+// back, so moves to the same game are played in the order given and
+// nothing is printed along the way.
+class GameServer {
+   public:
+    explicit GameServer(int threads);
+    GameServer(const GameServer &) = delete;
+    GameServer &operator=(const GameServer &) = delete;
+
+    // starts a game from the FEN and returns its id, or -1 for a FEN that
+    // is malformed or no legal position; the ids of ended games are reused
+    int newGame(std::string_view fen);
+    bool endGame(int id);
+    int gameCount() const;
+
+    // validates and plays every move, filling in the results
+    void play(std::vector<MoveRequest> &);
+
+    // answers the line protocol until "quit" or the end of input:
+    //   new [fen]         -> "new <id>", or "error bad fen"
+    //   move <id> <move>  -> "<id> <move> <result>", where the result is
+    //                        legal, check, checkmate, stalemate, illegal
+    //                        or unknown; an id that is not a number is
+    //                        echoed as -1
+    //   end <id>          -> "end <id>", or "error unknown game"
+    //   stats             -> games, moves and validation latency
+    //   quit
+    // consecutive moves are validated as one batch while more input is
+    // already waiting
+    void serve(std::istream &, std::ostream &);
+
+    // moves validated so far and the percentiles of the time each took
+    void reportStats(std::ostream &) const;
+
+   private:
+    struct Worker {
+        ChessBoard board;
+        std::vector<uint32_t> latencies;  // ns per move validated
+    };
+
+    std::vector<PackedPosition> games;
+    std::vector<bool> live;
+    std::vector<int> freeIds;
+    int liveCount;
+    ThreadPool pool;
+    std::vector<Worker> workers;
+
+    MoveResult validate(Worker &, MoveRequest &);
+};
+
+// entry point for "chess server [--threads n] [--socket path]" and
+// "chess server bench [games] [plies] [--threads n]"
+int serverCommand(int argc, char **argv);
+
+#endif
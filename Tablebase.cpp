@@ -0,0 +1,1007 @@
+#include "Tablebase.h"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "ChessPiece.h"
+
+// Syzygy tables are read as their generator wrote them, in its own terms:
+// squares run from a1 = 0 to h8 = 63, and pieces are coded 1 to 6 for
+// pawn, knight, bishop, rook, queen and king, plus 8 for black. The
+// position is turned into an index, which selects a value in blocks of
+// Huffman-coded symbols, each of which stands for a run of values paired
+// up recursively.
+
+enum TableKind { WdlTable, DtzTable };
+
+// per-table flags, as stored
+enum TableFlag {
+    SideToMove = 1,
+    Mapped = 2,
+    WinPlies = 4,
+    LossPlies = 8,
+    Wide = 16,
+    SingleValue = 128
+};
+
+enum ProbeState {
+    ProbeFail,
+    ProbeOk,
+    // a one-sided table holds the other side to move
+    ChangeSideToMove,
+    // the best move is a capture or pawn move that the table cannot show
+    ZeroingBestMove
+};
+
+// generator piece codes by Type, for white
+static const int TB_TYPE[6] = {1, 4, 2, 3, 6, 5};
+
+static const uint8_t MAGIC[2][4] = {{0x71, 0xE8, 0x23, 0x5D},
+                                    {0xD7, 0x66, 0x0C, 0xA5}};
+
+// index tables, in generator squares
+static int mapPawns[64];
+static int mapB1H1H7[64];
+static int mapA1D1D4[64];
+static int mapKK[10][64];
+static uint64_t binomial[TB_PIECES - 1][64];
+static uint64_t leadPawnIdx[TB_PIECES - 1][64];
+static uint64_t leadPawnsSize[TB_PIECES - 1][4];
+
+static int fileAt(int sq) { return sq & 7; }
+static int rankAt(int sq) { return sq >> 3; }
+static int flipFile(int sq) { return sq ^ 7; }
+static int flipRank(int sq) { return sq ^ 56; }
+// positive above the a1-h8 diagonal, negative below
+static int offDiagonal(int sq) { return rankAt(sq) - fileAt(sq); }
+
+template <typename T>
+static T readLittle(const void *address) {
+    T value;
+    memcpy(&value, address, sizeof(T));
+    return value;
+}
+
+static uint32_t readBig32(const void *address) {
+    return __builtin_bswap32(readLittle<uint32_t>(address));
+}
+
+static uint64_t readBig64(const void *address) {
+    return __builtin_bswap64(readLittle<uint64_t>(address));
+}
+
+typedef uint16_t Symbol;
+
+// a symbol's two halves, 12 bits each; a leaf holds its value on the left
+// and 0xFFF on the right
+struct SymbolPair {
+    uint8_t bytes[3];
+
+    Symbol left() const { return Symbol(((bytes[1] & 0xF) << 8) | bytes[0]); }
+    Symbol right() const { return Symbol((bytes[2] << 4) | (bytes[1] >> 4)); }
+};
+
+// where in the block lengths the value at index k * span + span / 2 lies
+struct SparseEntry {
+    uint8_t block[4];
+    uint8_t offset[2];
+};
+
+// how one side to move of one table, for one file of the leading pawn if
+// it has pawns, is indexed and compressed
+struct PairsData {
+    uint8_t flags;
+    size_t blockSize;
+    size_t span;
+    uint32_t blocks;
+    int maxSymbolLength;
+    int minSymbolLength;
+    const uint8_t *lowestSymbol;
+    const SymbolPair *tree;
+    const uint16_t *blockLength;
+    size_t blockLengthSize;
+    const SparseEntry *sparseIndex;
+    size_t sparseIndexSize;
+    const uint8_t *data;
+    // the lowest symbol of each length, left-aligned in 64 bits
+    std::vector<uint64_t> base;
+    // how many values, less one, each symbol stands for
+    std::vector<uint8_t> runLength;
+    int pieces[TB_PIECES];
+    uint64_t groupIdx[TB_PIECES + 1];
+    int groupLen[TB_PIECES + 1];
+    // DTZ only: where the values for wins, losses, cursed wins and
+    // blessed losses start in the value map
+    uint16_t mapIdx[4];
+};
+
+struct Table {
+    TableKind kind;
+    std::string name;
+    std::string path;
+    // the signature with the stronger side, as named, white; and black
+    uint64_t key;
+    uint64_t key2;
+    int pieceCount;
+    bool hasPawns;
+    bool hasUniquePieces;
+    // pawns of the leading color and of the other
+    int pawnCount[2];
+
+    std::atomic<bool> ready;
+    void *base;
+    size_t length;
+    const uint8_t *valueMap;
+    PairsData items[2][4];
+
+    Table() : ready(false), base(NULL), length(0), valueMap(NULL) {}
+    ~Table() {
+        if (base) munmap(base, length);
+    }
+
+    PairsData *get(int stm, int file) {
+        return &items[kind == WdlTable ? stm % 2 : 0][hasPawns ? file : 0];
+    }
+};
+
+struct TableEntry {
+    Table *wdl;
+    Table *dtz;
+};
+
+static std::vector<std::unique_ptr<Table> > tables;
+static std::unordered_map<uint64_t, TableEntry> tableIndex;
+static int largest = 0;
+static std::atomic<int> mappedCount(0);
+
+// piece counts by Type in 4 bits each, white's below black's
+static uint64_t signature(const int counts[2][6]) {
+    uint64_t key = 0;
+    for (int type = 0; type < 6; type++)
+        key |= uint64_t(counts[White][type]) << (4 * type) |
+               uint64_t(counts[Black][type]) << (24 + 4 * type);
+    return key;
+}
+
+static uint64_t signature(const ChessBoard &board) {
+    int counts[2][6];
+    for (Color color : {Black, White})
+        for (int type = 0; type < 6; type++)
+            counts[color][type] =
+                popCount(board.occupancy(color, Type(type)));
+    return signature(counts);
+}
+
+static void initIndexTables() {
+    static bool done = false;
+    if (done) return;
+    done = true;
+
+    int code = 0;
+    for (int sq = 0; sq < 64; sq++)
+        if (offDiagonal(sq) < 0) mapB1H1H7[sq] = code++;
+
+    // the a1-d1-d4 triangle below the diagonal first, then the diagonal
+    std::vector<int> diagonal;
+    code = 0;
+    for (int sq = 0; sq <= 27; sq++) {
+        if (offDiagonal(sq) < 0 && fileAt(sq) <= 3)
+            mapA1D1D4[sq] = code++;
+        else if (!offDiagonal(sq) && fileAt(sq) <= 3)
+            diagonal.push_back(sq);
+    }
+    for (int sq : diagonal) mapA1D1D4[sq] = code++;
+
+    // the 462 placements of two kings with the first in the triangle,
+    // those with both on the diagonal last
+    std::vector<std::pair<int, int> > bothOnDiagonal;
+    code = 0;
+    for (int idx = 0; idx < 10; idx++)
+        for (int s1 = 0; s1 <= 27; s1++) {
+            if (mapA1D1D4[s1] != idx || (!idx && s1 != 1)) continue;
+            for (int s2 = 0; s2 < 64; s2++) {
+                if (std::abs(fileAt(s1) - fileAt(s2)) <= 1 &&
+                    std::abs(rankAt(s1) - rankAt(s2)) <= 1)
+                    continue;
+                if (!offDiagonal(s1) && offDiagonal(s2) > 0) continue;
+                if (!offDiagonal(s1) && !offDiagonal(s2))
+                    bothOnDiagonal.push_back(std::make_pair(idx, s2));
+                else
+                    mapKK[idx][s2] = code++;
+            }
+        }
+    for (const std::pair<int, int> &p : bothOnDiagonal)
+        mapKK[p.first][p.second] = code++;
+
+    binomial[0][0] = 1;
+    for (int n = 1; n < 64; n++)
+        for (int k = 0; k < TB_PIECES - 1 && k <= n; k++)
+            binomial[k][n] = (k > 0 ? binomial[k - 1][n - 1] : 0) +
+                             (k < n ? binomial[k][n - 1] : 0);
+
+    // pawns count down from a2 towards the centre and up the board, so
+    // the leading pawn has the highest mapPawns
+    int available = 47;
+    for (int lead = 1; lead < TB_PIECES - 1; lead++)
+        for (int file = 0; file < 4; file++) {
+            uint64_t idx = 0;
+            for (int rank = 1; rank <= 6; rank++) {
+                const int sq = rank * 8 + file;
+                if (lead == 1) {
+                    mapPawns[sq] = available--;
+                    mapPawns[flipFile(sq)] = available--;
+                }
+                leadPawnIdx[lead][sq] = idx;
+                idx += binomial[lead - 1][mapPawns[sq]];
+            }
+            leadPawnsSize[lead][file] = idx;
+        }
+}
+
+// a table name such as "KRPvKR" into piece counts; false if it is not one
+static bool parseName(const std::string &name, int counts[2][6]) {
+    memset(counts, 0, sizeof(int) * 12);
+    const size_t v = name.find('v');
+    if (v == std::string::npos || name[0] != 'K' || v + 1 >= name.size() ||
+        name[v + 1] != 'K' || name.size() - 1 > size_t(TB_PIECES))
+        return false;
+
+    static const char *LETTERS = "PRNBKQ";
+    for (size_t i = 0; i < name.size(); i++) {
+        if (i == v) continue;
+        const char *letter = strchr(LETTERS, name[i]);
+        if (!letter || !*letter) return false;
+        counts[i < v ? White : Black][letter - LETTERS]++;
+    }
+    return counts[White][tKing] == 1 && counts[Black][tKing] == 1;
+}
+
+static void addTable(const std::string &directory, const std::string &name) {
+    int counts[2][6];
+    if (!parseName(name, counts)) return;
+    const uint64_t key = signature(counts);
+    if (tableIndex.count(key)) return;
+
+    int swapped[2][6];
+    for (int type = 0; type < 6; type++) {
+        swapped[White][type] = counts[Black][type];
+        swapped[Black][type] = counts[White][type];
+    }
+
+    TableEntry entry;
+    for (TableKind kind : {WdlTable, DtzTable}) {
+        Table *table = new Table();
+        tables.push_back(std::unique_ptr<Table>(table));
+        table->kind = kind;
+        table->name = name;
+        table->path =
+            directory + '/' + name + (kind == WdlTable ? ".rtbw" : ".rtbz");
+        table->key = key;
+        table->key2 = signature(swapped);
+        table->pieceCount = int(name.size()) - 1;
+        table->hasPawns = counts[White][tPawn] || counts[Black][tPawn];
+        table->hasUniquePieces = false;
+        for (Color color : {Black, White})
+            for (int type = 0; type < 6; type++)
+                if (type != tKing && counts[color][type] == 1)
+                    table->hasUniquePieces = true;
+
+        // the side with fewer pawns leads, as it compresses better
+        const int white = counts[White][tPawn], black = counts[Black][tPawn];
+        const bool whiteLeads = !black || (white && black >= white);
+        table->pawnCount[0] = whiteLeads ? white : black;
+        table->pawnCount[1] = whiteLeads ? black : white;
+        (kind == WdlTable ? entry.wdl : entry.dtz) = table;
+    }
+
+    tableIndex[key] = entry;
+    tableIndex[entry.wdl->key2] = entry;
+    largest = std::max(largest, entry.wdl->pieceCount);
+}
+
+int initTablebases(const std::string &paths) {
+    initIndexTables();
+    tableIndex.clear();
+    tables.clear();
+    largest = 0;
+    mappedCount = 0;
+
+    for (size_t start = 0; start < paths.size();) {
+        size_t end = paths.find(':', start);
+        if (end == std::string::npos) end = paths.size();
+        const std::string directory = paths.substr(start, end - start);
+        start = end + 1;
+
+        DIR *dir = directory.empty() ? NULL : opendir(directory.c_str());
+        if (!dir) continue;
+        while (const dirent *file = readdir(dir)) {
+            const std::string name = file->d_name;
+            if (name.size() > 5 &&
+                !name.compare(name.size() - 5, 5, ".rtbw"))
+                addTable(directory, name.substr(0, name.size() - 5));
+        }
+        closedir(dir);
+    }
+    return int(tables.size() / 2);
+}
+
+int tablebaseLargest() { return largest; }
+int tablebasesMapped() { return mappedCount; }
+
+// groups the pieces encoded together, and works out each group's factor
+// in the index: the leading pawns or pieces, then the other side's pawns,
+// then same pieces of the same color, in the order the table gives
+static void setGroups(const Table &table, PairsData &d, const int order[2],
+                      int file) {
+    int n = 0;
+    int firstLen = table.hasPawns ? 0 : table.hasUniquePieces ? 3 : 2;
+    d.groupLen[n] = 1;
+    for (int i = 1; i < table.pieceCount; i++) {
+        if (--firstLen > 0 || d.pieces[i] == d.pieces[i - 1])
+            d.groupLen[n]++;
+        else
+            d.groupLen[++n] = 1;
+    }
+    d.groupLen[++n] = 0;
+
+    const bool bothPawns = table.hasPawns && table.pawnCount[1];
+    int next = bothPawns ? 2 : 1;
+    int freeSquares = 64 - d.groupLen[0] - (bothPawns ? d.groupLen[1] : 0);
+    uint64_t idx = 1;
+    for (int k = 0; next < n || k == order[0] || k == order[1]; k++) {
+        if (k == order[0]) {
+            d.groupIdx[0] = idx;
+            idx *= table.hasPawns ? leadPawnsSize[d.groupLen[0]][file]
+                   : table.hasUniquePieces ? 31332
+                                           : 462;
+        } else if (k == order[1]) {
+            d.groupIdx[1] = idx;
+            idx *= binomial[d.groupLen[1]][48 - d.groupLen[0]];
+        } else {
+            d.groupIdx[next] = idx;
+            idx *= binomial[d.groupLen[next]][freeSquares];
+            freeSquares -= d.groupLen[next++];
+        }
+    }
+    d.groupIdx[n] = idx;
+}
+
+static uint8_t setRunLength(PairsData &d, Symbol s,
+                            std::vector<bool> &visited) {
+    visited[s] = true;
+    const Symbol right = d.tree[s].right();
+    if (right == 0xFFF) return 0;
+
+    const Symbol left = d.tree[s].left();
+    if (!visited[left]) d.runLength[left] = setRunLength(d, left, visited);
+    if (!visited[right]) d.runLength[right] = setRunLength(d, right, visited);
+    return d.runLength[left] + d.runLength[right] + 1;
+}
+
+static const uint8_t *setSizes(PairsData &d, const uint8_t *data) {
+    d.flags = *data++;
+    if (d.flags & SingleValue) {
+        d.blocks = 0;
+        d.span = d.blockLengthSize = d.sparseIndexSize = 0;
+        // the one value every position has
+        d.minSymbolLength = *data++;
+        return data;
+    }
+
+    const uint64_t size =
+        d.groupIdx[std::find(d.groupLen, d.groupLen + TB_PIECES, 0) -
+                   d.groupLen];
+    d.blockSize = size_t(1) << *data++;
+    d.span = size_t(1) << *data++;
+    d.sparseIndexSize = size_t((size + d.span - 1) / d.span);
+    const int padding = *data++;
+    d.blocks = readLittle<uint32_t>(data);
+    data += sizeof(uint32_t);
+    // padded so that the sparse index never points past the end
+    d.blockLengthSize = d.blocks + padding;
+    d.maxSymbolLength = *data++;
+    d.minSymbolLength = *data++;
+    d.lowestSymbol = data;
+    d.base.assign(d.maxSymbolLength - d.minSymbolLength + 1, 0);
+
+    // canonical Huffman codes: longer codes have lower values, so the
+    // lowest code of each length, left-aligned, falls as the length grows
+    for (int i = int(d.base.size()) - 2; i >= 0; i--)
+        d.base[i] = (d.base[i + 1] +
+                     readLittle<Symbol>(d.lowestSymbol + 2 * i) -
+                     readLittle<Symbol>(d.lowestSymbol + 2 * (i + 1))) /
+                    2;
+    for (size_t i = 0; i < d.base.size(); i++)
+        d.base[i] <<= 64 - i - d.minSymbolLength;
+
+    data += d.base.size() * sizeof(Symbol);
+    d.runLength.assign(readLittle<uint16_t>(data), 0);
+    data += sizeof(uint16_t);
+    d.tree = reinterpret_cast<const SymbolPair *>(data);
+
+    std::vector<bool> visited(d.runLength.size());
+    for (size_t s = 0; s < d.runLength.size(); s++)
+        if (!visited[s]) d.runLength[s] = setRunLength(d, Symbol(s), visited);
+    return data + d.runLength.size() * sizeof(SymbolPair) +
+           (d.runLength.size() & 1);
+}
+
+static const uint8_t *align(const uint8_t *data, uintptr_t to) {
+    return reinterpret_cast<const uint8_t *>(
+        (reinterpret_cast<uintptr_t>(data) + to - 1) & ~(to - 1));
+}
+
+static const uint8_t *setValueMap(Table &table, const uint8_t *data,
+                                  int maxFile) {
+    if (table.kind == WdlTable) return data;
+
+    table.valueMap = data;
+    for (int file = 0; file <= maxFile; file++) {
+        PairsData &d = *table.get(0, file);
+        if (!(d.flags & Mapped)) continue;
+        if (d.flags & Wide) {
+            data = align(data, 2);
+            for (int i = 0; i < 4; i++) {
+                d.mapIdx[i] = uint16_t((data - table.valueMap) / 2 + 1);
+                data += 2 * readLittle<uint16_t>(data) + 2;
+            }
+        } else {
+            for (int i = 0; i < 4; i++) {
+                d.mapIdx[i] = uint16_t(data - table.valueMap + 1);
+                data += *data + 1;
+            }
+        }
+    }
+    return align(data, 2);
+}
+
+// reads the layout of a table just mapped: piece order and groups, then
+// the sizes, value map, sparse index, block lengths and blocks of each
+// side and file
+static void setup(Table &table, const uint8_t *data) {
+    data++;  // whether split by side to move, and whether with pawns
+
+    const int sides =
+        table.kind == WdlTable && table.key != table.key2 ? 2 : 1;
+    const int maxFile = table.hasPawns ? 3 : 0;
+    const bool bothPawns = table.hasPawns && table.pawnCount[1];
+
+    for (int file = 0; file <= maxFile; file++) {
+        for (int i = 0; i < sides; i++) *table.get(i, file) = PairsData();
+
+        const int order[2][2] = {
+            {*data & 0xF, bothPawns ? *(data + 1) & 0xF : 0xF},
+            {*data >> 4, bothPawns ? *(data + 1) >> 4 : 0xF}};
+        data += 1 + bothPawns;
+
+        for (int k = 0; k < table.pieceCount; k++, data++)
+            for (int i = 0; i < sides; i++)
+                table.get(i, file)->pieces[k] = i ? *data >> 4 : *data & 0xF;
+        for (int i = 0; i < sides; i++)
+            setGroups(table, *table.get(i, file), order[i], file);
+    }
+    data = align(data, 2);
+
+    for (int file = 0; file <= maxFile; file++)
+        for (int i = 0; i < sides; i++)
+            data = setSizes(*table.get(i, file), data);
+
+    data = setValueMap(table, data, maxFile);
+
+    for (int file = 0; file <= maxFile; file++)
+        for (int i = 0; i < sides; i++) {
+            PairsData &d = *table.get(i, file);
+            d.sparseIndex = reinterpret_cast<const SparseEntry *>(data);
+            data += d.sparseIndexSize * sizeof(SparseEntry);
+        }
+    for (int file = 0; file <= maxFile; file++)
+        for (int i = 0; i < sides; i++) {
+            PairsData &d = *table.get(i, file);
+            d.blockLength = reinterpret_cast<const uint16_t *>(data);
+            data += d.blockLengthSize * sizeof(uint16_t);
+        }
+    for (int file = 0; file <= maxFile; file++)
+        for (int i = 0; i < sides; i++) {
+            PairsData &d = *table.get(i, file);
+            data = align(data, 64);
+            d.data = data;
+            data += size_t(d.blocks) * d.blockSize;
+        }
+}
+
+// maps the table's file the first time it is needed; NULL if it is
+// missing or damaged. Safe to call from several threads.
+static void *mapTable(Table &table) {
+    static std::mutex lock;
+    if (table.ready.load(std::memory_order_acquire)) return table.base;
+
+    std::lock_guard<std::mutex> guard(lock);
+    if (table.ready.load(std::memory_order_relaxed)) return table.base;
+
+    const int fd = open(table.path.c_str(), O_RDONLY);
+    struct stat info;
+    // every file is a whole number of 64-byte blocks and a 16-byte header
+    if (fd >= 0 && fstat(fd, &info) == 0 && info.st_size % 64 == 16) {
+        void *map = mmap(NULL, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        if (map != MAP_FAILED) {
+            if (!memcmp(map, MAGIC[table.kind], 4)) {
+                madvise(map, info.st_size, MADV_RANDOM);
+                table.base = map;
+                table.length = info.st_size;
+                setup(table, static_cast<const uint8_t *>(map) + 4);
+                mappedCount++;
+            } else {
+                munmap(map, info.st_size);
+            }
+        }
+    }
+    if (fd >= 0) close(fd);
+
+    table.ready.store(true, std::memory_order_release);
+    return table.base;
+}
+
+// the value at an index: find its block through the sparse index and the
+// block lengths, then walk the block's symbols to the one covering it and
+// split that down to a single value
+static int decompress(const PairsData &d, uint64_t idx) {
+    if (d.flags & SingleValue) return d.minSymbolLength;
+
+    const uint32_t k = uint32_t(idx / d.span);
+    uint32_t block = readLittle<uint32_t>(d.sparseIndex[k].block);
+    int offset = readLittle<uint16_t>(d.sparseIndex[k].offset);
+    offset += int(idx % d.span) - int(d.span / 2);
+
+    while (offset < 0) offset += d.blockLength[--block] + 1;
+    while (offset > d.blockLength[block]) offset -= d.blockLength[block++] + 1;
+
+    const uint8_t *ptr = d.data + uint64_t(block) * d.blockSize;
+    uint64_t bits = readBig64(ptr);
+    ptr += 8;
+    int bitCount = 64;
+    Symbol sym;
+    for (;;) {
+        int len = 0;
+        while (bits < d.base[len]) len++;
+        sym = Symbol((bits - d.base[len]) >> (64 - len - d.minSymbolLength));
+        sym += readLittle<Symbol>(d.lowestSymbol + 2 * len);
+
+        if (offset < d.runLength[sym] + 1) break;
+        offset -= d.runLength[sym] + 1;
+        len += d.minSymbolLength;
+        bits <<= len;
+        bitCount -= len;
+        if (bitCount <= 32) {
+            bitCount += 32;
+            bits |= uint64_t(readBig32(ptr)) << (64 - bitCount);
+            ptr += 4;
+        }
+    }
+
+    // the halves of a pair are adjacent runs
+    while (d.runLength[sym]) {
+        const Symbol left = d.tree[sym].left();
+        if (offset < d.runLength[left] + 1) {
+            sym = left;
+        } else {
+            offset -= d.runLength[left] + 1;
+            sym = d.tree[sym].right();
+        }
+    }
+    return d.tree[sym].left();
+}
+
+// a DTZ table's value in plies, undoing its frequency ordering
+static int mapDtz(Table &table, int file, int value, WdlScore wdl) {
+    static const int WDL_MAP[] = {1, 3, 0, 2, 0};
+    const PairsData &d = *table.get(0, file);
+
+    if (d.flags & Mapped) {
+        const int idx = d.mapIdx[WDL_MAP[wdl + 2]] + value;
+        value = d.flags & Wide
+                    ? readLittle<uint16_t>(table.valueMap + 2 * idx)
+                    : table.valueMap[idx];
+    }
+    if ((wdl == WdlWin && !(d.flags & WinPlies)) ||
+        (wdl == WdlLoss && !(d.flags & LossPlies)) || wdl == WdlCursedWin ||
+        wdl == WdlBlessedLoss)
+        value *= 2;
+    return value + 1;
+}
+
+// where the position lies in the table, and which part of the table holds
+// it: the side to move's, and the leading pawn's file's
+static uint64_t positionIndex(const ChessBoard &board, Table &table,
+                              PairsData *&pairs, int &tbFile,
+                              ProbeState &state) {
+    int squares[TB_PIECES], pieces[TB_PIECES];
+    int size = 0, leadPawns = 0;
+    tbFile = 0;
+
+    // tables hold the stronger side as white, and a table with the same
+    // pieces on both sides holds white to move only
+    const uint64_t key = signature(board);
+    const bool flip = key != table.key ||
+                      (table.key == table.key2 && board.activeColor == Black);
+    const int flipColor = flip ? 8 : 0, flipSquares = flip ? 56 : 0;
+    const int stm = (board.activeColor == Black) != flip;
+
+    // every piece in the generator's terms, in its square order: the
+    // board's ranks reversed
+    int allSquares[TB_PIECES], allPieces[TB_PIECES], count = 0;
+    for (Bitboard b = __builtin_bswap64(board.occupancy()); b;) {
+        const int sq = popLsb(b);
+        const ChessPiece *piece = board.pieceAt(sq ^ 56);
+        allSquares[count] = sq;
+        allPieces[count++] =
+            TB_TYPE[piece->type()] + (piece->color() == Black ? 8 : 0);
+    }
+
+    // with pawns there is a table for each file of the leading pawn, the
+    // one nearest the edge and then the lowest
+    if (table.hasPawns) {
+        const int pawn = table.get(0, 0)->pieces[0] ^ flipColor;
+        for (int i = 0; i < count; i++)
+            if (allPieces[i] == pawn)
+                squares[size++] = allSquares[i] ^ flipSquares;
+        leadPawns = size;
+        std::swap(squares[0],
+                  *std::max_element(squares, squares + leadPawns,
+                                    [](int a, int b) {
+                                        return mapPawns[a] < mapPawns[b];
+                                    }));
+        tbFile = std::min(fileAt(squares[0]), 7 - fileAt(squares[0]));
+    }
+
+    // one-sided DTZ tables
+    if (table.kind == DtzTable &&
+        (table.get(stm, tbFile)->flags & SideToMove) != stm &&
+        !(table.key == table.key2 && !table.hasPawns)) {
+        state = ChangeSideToMove;
+        return 0;
+    }
+
+    const int pawn = table.hasPawns ? table.get(0, 0)->pieces[0] ^ flipColor
+                                    : -1;
+    for (int i = 0; i < count; i++) {
+        if (allPieces[i] == pawn) continue;
+        squares[size] = allSquares[i] ^ flipSquares;
+        pieces[size++] = allPieces[i] ^ flipColor;
+    }
+
+    PairsData &d = *(pairs = table.get(stm, tbFile));
+
+    // the pieces in the order the table encodes them
+    for (int i = leadPawns; i < size - 1; i++)
+        for (int j = i + 1; j < size; j++)
+            if (d.pieces[i] == pieces[j]) {
+                std::swap(pieces[i], pieces[j]);
+                std::swap(squares[i], squares[j]);
+                break;
+            }
+
+    // the leading piece onto files a to d
+    if (fileAt(squares[0]) > 3)
+        for (int i = 0; i < size; i++) squares[i] = flipFile(squares[i]);
+
+    uint64_t idx;
+    if (table.hasPawns) {
+        idx = leadPawnIdx[leadPawns][squares[0]];
+        std::stable_sort(squares + 1, squares + leadPawns, [](int a, int b) {
+            return mapPawns[a] < mapPawns[b];
+        });
+        for (int i = 1; i < leadPawns; i++)
+            idx += binomial[i][mapPawns[squares[i]]];
+    } else {
+        // the leading piece onto ranks 1 to 4, and the first of the
+        // leading group off the diagonal below it
+        if (rankAt(squares[0]) > 3)
+            for (int i = 0; i < size; i++) squares[i] = flipRank(squares[i]);
+        for (int i = 0; i < d.groupLen[0]; i++) {
+            if (!offDiagonal(squares[i])) continue;
+            if (offDiagonal(squares[i]) > 0)
+                for (int j = i; j < size; j++)
+                    squares[j] = ((squares[j] >> 3) | (squares[j] << 3)) & 63;
+            break;
+        }
+
+        if (table.hasUniquePieces) {
+            // three unique pieces, kings included, are encoded together
+            const int adjust1 = squares[1] > squares[0];
+            const int adjust2 =
+                (squares[2] > squares[0]) + (squares[2] > squares[1]);
+            if (offDiagonal(squares[0]))
+                idx = (mapA1D1D4[squares[0]] * 63 + (squares[1] - adjust1)) *
+                          62 +
+                      squares[2] - adjust2;
+            else if (offDiagonal(squares[1]))
+                idx = (6 * 63 + rankAt(squares[0]) * 28 +
+                       mapB1H1H7[squares[1]]) *
+                          62 +
+                      squares[2] - adjust2;
+            else if (offDiagonal(squares[2]))
+                idx = 6 * 63 * 62 + 4 * 28 * 62 +
+                      rankAt(squares[0]) * 7 * 28 +
+                      (rankAt(squares[1]) - adjust1) * 28 +
+                      mapB1H1H7[squares[2]];
+            else
+                idx = 6 * 63 * 62 + 4 * 28 * 62 + 4 * 7 * 28 +
+                      rankAt(squares[0]) * 7 * 6 +
+                      (rankAt(squares[1]) - adjust1) * 6 +
+                      (rankAt(squares[2]) - adjust2);
+        } else {
+            idx = mapKK[mapA1D1D4[squares[0]]][squares[1]];
+        }
+    }
+
+    // then each further group by its squares, less those taken before
+    idx *= d.groupIdx[0];
+    int *group = squares + d.groupLen[0];
+    bool remainingPawns = table.hasPawns && table.pawnCount[1];
+    for (int next = 1; d.groupLen[next]; next++) {
+        std::stable_sort(group, group + d.groupLen[next]);
+        uint64_t n = 0;
+        for (int i = 0; i < d.groupLen[next]; i++) {
+            const int adjust = int(std::count_if(
+                squares, group, [&](int sq) { return group[i] > sq; }));
+            n += binomial[i + 1][group[i] - adjust - 8 * remainingPawns];
+        }
+        remainingPawns = false;
+        idx += n * d.groupIdx[next];
+        group += d.groupLen[next];
+    }
+    return idx;
+}
+
+// the raw value the table holds for the position
+static int probeTable(ChessBoard &board, Table &table, WdlScore wdl,
+                      ProbeState &state) {
+    PairsData *pairs;
+    int file;
+    const uint64_t idx = positionIndex(board, table, pairs, file, state);
+    if (state == ChangeSideToMove) return 0;
+
+    const int value = decompress(*pairs, idx);
+    return table.kind == WdlTable ? value - 2
+                                  : mapDtz(table, file, value, wdl);
+}
+
+static int probeKind(ChessBoard &board, TableKind kind, WdlScore wdl,
+                     ProbeState &state) {
+    if (popCount(board.occupancy()) == 2) return WdlDraw;
+
+    const std::unordered_map<uint64_t, TableEntry>::const_iterator found =
+        tableIndex.find(signature(board));
+    if (found == tableIndex.end()) {
+        state = ProbeFail;
+        return 0;
+    }
+    Table &table = kind == WdlTable ? *found->second.wdl : *found->second.dtz;
+    if (!mapTable(table)) {
+        state = ProbeFail;
+        return 0;
+    }
+    return probeTable(board, table, wdl, state);
+}
+
+static bool isPawnMove(const ChessBoard &board, ChessMove move) {
+    return board.occupancy(board.activeColor, tPawn) & squareBB(move.from());
+}
+
+// the tables need not hold positions where a capture, or with zeroing a
+// pawn move too, is best, nor en passant; so those moves are tried and
+// their results taken over the table's when better
+static WdlScore searchWdl(ChessBoard &board, bool zeroing,
+                          ProbeState &state) {
+    MoveList moves;
+    board.generateLegalMoves(moves);
+
+    WdlScore best = WdlLoss;
+    int tried = 0;
+    for (ChessMove move : moves) {
+        if (!move.isCapture() && (!zeroing || !isPawnMove(board, move)))
+            continue;
+        tried++;
+
+        board.makeMove(move);
+        const WdlScore value = WdlScore(-searchWdl(board, false, state));
+        board.unmakeMove();
+        if (state == ProbeFail) return WdlDraw;
+
+        if (value > best) {
+            best = value;
+            if (value >= WdlWin) {
+                state = ZeroingBestMove;
+                return value;
+            }
+        }
+    }
+
+    // with every move tried the table is not needed, and may be wrong
+    const bool allTried = tried && tried == moves.size();
+    WdlScore value = best;
+    if (!allTried) {
+        value = WdlScore(probeKind(board, WdlTable, WdlDraw, state));
+        if (state == ProbeFail) return WdlDraw;
+    }
+
+    if (best >= value) {
+        state = best > WdlDraw || allTried ? ZeroingBestMove : ProbeOk;
+        return best;
+    }
+    state = ProbeOk;
+    return value;
+}
+
+// the DTZ just before a zeroing move into a position of this result
+static int dtzBeforeZeroing(WdlScore wdl) {
+    return wdl == WdlWin           ? 1
+           : wdl == WdlCursedWin   ? 101
+           : wdl == WdlBlessedLoss ? -101
+           : wdl == WdlLoss        ? -1
+                                   : 0;
+}
+
+static int signOf(int value) { return (value > 0) - (value < 0); }
+
+// whether the tables could cover the position at all
+static bool covered(const ChessBoard &board) {
+    return popCount(board.occupancy()) == 2 ||
+           tableIndex.count(signature(board));
+}
+
+bool probeWdl(ChessBoard &board, WdlScore &wdl) {
+    if (!covered(board)) return false;
+    ProbeState state = ProbeOk;
+    wdl = searchWdl(board, false, state);
+    return state != ProbeFail;
+}
+
+bool probeDtz(ChessBoard &board, int &dtz) {
+    dtz = 0;
+    if (!covered(board)) return false;
+    ProbeState state = ProbeOk;
+    const WdlScore wdl = searchWdl(board, true, state);
+    if (state == ProbeFail) return false;
+    if (wdl == WdlDraw) return true;
+    if (state == ZeroingBestMove) {
+        dtz = dtzBeforeZeroing(wdl);
+        return true;
+    }
+
+    const int value = probeKind(board, DtzTable, wdl, state);
+    if (state == ProbeFail) return false;
+    if (state != ChangeSideToMove) {
+        dtz = (value + 100 * (wdl == WdlBlessedLoss || wdl == WdlCursedWin)) *
+              signOf(wdl);
+        return true;
+    }
+
+    // the table holds the other side to move: the best reply decides
+    MoveList moves;
+    board.generateLegalMoves(moves);
+    int best = 0xFFFF;
+    for (ChessMove move : moves) {
+        const bool zeroing = move.isCapture() || isPawnMove(board, move);
+        board.makeMove(move);
+        int value;
+        bool ok;
+        if (zeroing) {
+            state = ProbeOk;
+            value = -dtzBeforeZeroing(searchWdl(board, false, state));
+            ok = state != ProbeFail;
+        } else {
+            ok = probeDtz(board, value);
+            value = -value;
+        }
+        if (ok && value == 1 && board.status() == Checkmate) best = 1;
+        board.unmakeMove();
+        if (!ok) return false;
+
+        if (!zeroing) value += signOf(value);
+        if (value < best && signOf(value) == signOf(wdl)) best = value;
+    }
+    dtz = best == 0xFFFF ? -1 : best;
+    return true;
+}
+
+bool probeRoot(ChessBoard &board, MoveList &moves) {
+    const int fifty = board.halfmoves();
+    int ranks[MAX_MOVES], bestRank = INT_MIN;
+    for (int i = 0; i < moves.size(); i++) {
+        board.makeMove(moves[i]);
+        int dtz = 0;
+        bool ok = true;
+        if (board.halfmoves() == 0) {
+            WdlScore wdl;
+            ok = probeWdl(board, wdl);
+            dtz = dtzBeforeZeroing(WdlScore(-wdl));
+        } else if (!board.isRepetition() && board.halfmoves() < 100) {
+            ok = probeDtz(board, dtz);
+            dtz = -dtz;
+            dtz += signOf(dtz);
+        }
+        if (ok && dtz == 2 && board.status() == Checkmate) dtz = 1;
+        board.unmakeMove();
+        if (!ok) return false;
+
+        // wins within the fifty moves, fastest first; then wins lost to
+        // the rule, draws, losses saved by it, and losses, slowest first
+        int rank;
+        if (dtz > 0)
+            rank = dtz + fifty <= 100 ? 2000 - dtz : 1;
+        else if (dtz < 0)
+            rank = -dtz + fifty <= 100 ? -2000 - dtz : -1;
+        else
+            rank = 0;
+        ranks[i] = rank;
+        bestRank = std::max(bestRank, rank);
+    }
+
+    MoveList kept;
+    for (int i = 0; i < moves.size(); i++)
+        if (ranks[i] == bestRank) kept.push(moves[i]);
+    moves = kept;
+    return true;
+}
+
+int tablebaseCommand(int argc, char **argv) {
+    if (argc < 1) {
+        std::cout << "usage: chess tb <directories> [fen]" << std::endl;
+        return 1;
+    }
+
+    const int found = initTablebases(argv[0]);
+    std::cout << "tables    " << found << " up to " << tablebaseLargest()
+              << " pieces" << std::endl;
+    if (argc < 2) return 0;
+
+    ChessBoard board;
+    board.setOutput(NULL);
+    if (!board.setFen(argv[1])) {
+        std::cout << "invalid fen: " << argv[1] << std::endl;
+        return 1;
+    }
+    if (board.canCastle() ||
+        popCount(board.occupancy()) > tablebaseLargest()) {
+        std::cout << "not in the tables" << std::endl;
+        return 1;
+    }
+
+    static const char *WDL_NAME[] = {"loss", "blessed loss", "draw",
+                                     "cursed win", "win"};
+    WdlScore wdl;
+    int dtz;
+    if (!probeWdl(board, wdl) || !probeDtz(board, dtz)) {
+        std::cout << "probe failed: a table is missing" << std::endl;
+        return 1;
+    }
+    std::cout << "wdl       " << WDL_NAME[wdl + 2] << "\ndtz       " << dtz
+              << std::endl;
+
+    MoveList moves;
+    board.generateLegalMoves(moves);
+    if (probeRoot(board, moves)) {
+        char buf[6];
+        std::cout << "best     ";
+        for (ChessMove move : moves) std::cout << ' ' << move.str(buf);
+        std::cout << std::endl;
+    }
+    std::cout << "mapped    " << tablebasesMapped() << std::endl;
+    return 0;
+}
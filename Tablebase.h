@@ -0,0 +1,53 @@
+#ifndef TABLEBASE_H
+#define TABLEBASE_H
+
+#include <cstdint>
+#include <string>
+
+#include "ChessBoard.h"
+#include "ChessMove.h"
+
+// the most pieces, kings included, any Syzygy table can hold
+const int TB_PIECES = 7;
+
+// the result with perfect play, from the side to move; cursed wins and
+// blessed losses are drawn by the fifty-move rule
+enum WdlScore {
+    WdlLoss = -2,
+    WdlBlessedLoss,
+    WdlDraw,
+    WdlCursedWin,
+    WdlWin
+};
+
+// looks for Syzygy tables (KRvK.rtbw and KRvK.rtbz, ...) in a list of
+// directories separated by ':', replacing any found before, and returns
+// how many were found. Only names are read here: a file is mapped into
+// memory when a probe first needs it.
+int initTablebases(const std::string &paths);
+// the most pieces in any table found, or 0 without tables
+int tablebaseLargest();
+
+// the win/draw/loss of the position, which must have no castling rights
+// and no more pieces than tablebaseLargest(); false if a table is missing
+bool probeWdl(ChessBoard &, WdlScore &);
+
+// the plies to the next capture or pawn move that keeps the result, signed
+// like the result and counted from a fresh fifty-move counter: 1..100 for
+// a win, more than 100 for a cursed win, 0 for a draw and the negative of
+// those for losses. May be one ply too long.
+bool probeDtz(ChessBoard &, int &dtz);
+
+// narrows the legal moves at the root to those keeping the best result
+// the tables allow, given the fifty-move counter, and when winning to
+// those winning fastest; false, leaving the moves alone, if a table is
+// missing
+bool probeRoot(ChessBoard &, MoveList &);
+
+// tables mapped into memory so far
+int tablebasesMapped();
+
+// entry point for "chess tb <directories> [fen]"
+int tablebaseCommand(int argc, char **argv);
+
+#endif
@@ -0,0 +1,90 @@
+#include "ThreadPool.h"
+
+ThreadPool::ThreadPool(int count)
+    : queues(count > 0 ? count : 1),
+      pending(0),
+      queued(0),
+      next(0),
+      stopping(false) {
+    for (int i = 0; i < size(); i++)
+        threads.push_back(std::thread(&ThreadPool::run, this, i));
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (std::thread &thread : threads) thread.join();
+}
+
+int ThreadPool::size() const { return int(queues.size()); }
+
+void ThreadPool::submit(Task task, int worker) {
+    if (worker < 0) worker = next++ % size();
+
+    pending++;
+    {
+        std::lock_guard<std::mutex> guard(queues[worker].lock);
+        queues[worker].tasks.push_back(std::move(task));
+    }
+    queued++;
+
+    // taking the pool lock orders this against a worker deciding to sleep
+    std::lock_guard<std::mutex> guard(lock);
+    wake.notify_all();
+}
+
+void ThreadPool::wait() {
+    std::unique_lock<std::mutex> guard(lock);
+    idle.wait(guard, [this] { return pending == 0; });
+}
+
+// pops the newest task of our own deque, or steals the oldest of another
+bool ThreadPool::take(int worker, Task &task) {
+    {
+        Queue &own = queues[worker];
+        std::lock_guard<std::mutex> guard(own.lock);
+        if (!own.tasks.empty()) {
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            queued--;
+            return true;
+        }
+    }
+
+    for (int i = 1; i < size(); i++) {
+        Queue &victim = queues[(worker + i) % size()];
+        std::lock_guard<std::mutex> guard(victim.lock);
+        if (!victim.tasks.empty()) {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            queued--;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void ThreadPool::run(int worker) {
+    for (;;) {
+        Task task;
+        if (take(worker, task)) {
+            task(worker);
+            if (--pending == 0) {
+                std::lock_guard<std::mutex> guard(lock);
+                idle.notify_all();
+            }
+            continue;
+        }
+
+        // a running task cannot be stolen, so only a queued one is worth
+        // waking for; submit notifies under this lock once it has counted
+        // its task, so none is missed
+        std::unique_lock<std::mutex> guard(lock);
+        wake.wait(guard, [this] { return stopping || queued > 0; });
+        if (stopping) return;
+    }
+}
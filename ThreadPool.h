@@ -0,0 +1,55 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// fixed set of worker threads, each with its own task deque; a worker runs
+// its newest task first and steals the oldest task of another worker when
+// its own deque is empty. Tasks receive the index of the worker running
+// them so they can use per-worker state.
+class ThreadPool {
+   public:
+    typedef std::function<void(int)> Task;
+
+    explicit ThreadPool(int threads);
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+    ~ThreadPool();
+
+    int size() const;
+
+    // queues a task on the given worker, or round-robin when worker < 0
+    void submit(Task task, int worker = -1);
+
+    // blocks until every submitted task has finished
+    void wait();
+
+   private:
+    struct Queue {
+        std::deque<Task> tasks;
+        std::mutex lock;
+    };
+
+    std::vector<std::thread> threads;
+    std::vector<Queue> queues;
+
+    std::mutex lock;
+    std::condition_variable wake;
+    std::condition_variable idle;
+    // tasks submitted and not yet finished, and of those not yet taken
+    std::atomic<int> pending;
+    std::atomic<int> queued;
+    int next;
+    bool stopping;
+
+    bool take(int worker, Task &task);
+    void run(int worker);
+};
+
+#endif
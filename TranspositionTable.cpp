@@ -0,0 +1,176 @@
+#include "TranspositionTable.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+// data word: move 0-15, score 16-31, eval 32-47, depth 48-55,
+// bound 56-57, generation 58-63
+static uint64_t pack(ChessMove move, int score, int eval, int depth,
+                     Bound bound, uint8_t generation) {
+    return uint64_t(move.raw()) | uint64_t(uint16_t(int16_t(score))) << 16 |
+           uint64_t(uint16_t(int16_t(eval))) << 32 |
+           uint64_t(uint8_t(depth < 0 ? 0 : depth)) << 48 |
+           uint64_t(bound) << 56 |
+           uint64_t(generation & 63) << 58;
+}
+
+static ChessMove moveOf(uint64_t data) { return ChessMove(uint16_t(data)); }
+static int scoreOf(uint64_t data) { return int16_t(data >> 16); }
+static int evalOf(uint64_t data) { return int16_t(data >> 32); }
+static int depthOf(uint64_t data) { return uint8_t(data >> 48); }
+static Bound boundOf(uint64_t data) { return Bound((data >> 56) & 3); }
+static uint8_t generationOf(uint64_t data) { return data >> 58; }
+
+TranspositionTable::TranspositionTable()
+    : buckets(NULL), bucketCount(0), allocated(0), generation(0) {
+    resize(16);
+}
+
+TranspositionTable::~TranspositionTable() { release(); }
+
+void TranspositionTable::release() {
+    free(buckets);
+    buckets = NULL;
+    bucketCount = allocated = 0;
+}
+
+bool TranspositionTable::resize(size_t megabytes, int threads) {
+    if (megabytes < 1) megabytes = 1;
+
+    // on Linux align to a 2 MB boundary and ask for transparent huge pages
+    // to save TLB misses on random probes
+    size_t bytes = megabytes << 20;
+#ifdef __linux__
+    const size_t alignment = 2 << 20;
+#else
+    const size_t alignment = alignof(TTBucket);
+#endif
+    const size_t rounded = (bytes + alignment - 1) / alignment * alignment;
+    TTBucket *table =
+        static_cast<TTBucket *>(aligned_alloc(alignment, rounded));
+    if (!table) {
+        // too much to ask for: keep the table there is, or without one the
+        // smallest usable table
+        if (buckets) {
+            clear(threads);
+            return false;
+        }
+        table = static_cast<TTBucket *>(aligned_alloc(alignment, alignment));
+        if (!table) throw std::bad_alloc();
+        bytes = alignment;
+    }
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+    madvise(table, bytes, MADV_HUGEPAGE);
+#endif
+
+    release();
+    buckets = table;
+    allocated = bytes;
+    bucketCount = allocated / sizeof(TTBucket);
+    clear(threads);
+    return allocated == megabytes << 20;
+}
+
+void TranspositionTable::clear(int threads) {
+    if (threads < 1) threads = 1;
+    char *base = reinterpret_cast<char *>(buckets);
+    const size_t bytes = bucketCount * sizeof(TTBucket);
+    const size_t stride = bytes / threads;
+
+    std::vector<std::thread> workers;
+    for (int i = 0; i < threads; i++) {
+        const size_t begin = i * stride;
+        const size_t length = i == threads - 1 ? bytes - begin : stride;
+        workers.push_back(std::thread(
+            [base, begin, length] { memset(base + begin, 0, length); }));
+    }
+    for (std::thread &worker : workers) worker.join();
+
+    generation = 0;
+}
+
+void TranspositionTable::newSearch() { generation = (generation + 1) & 63; }
+
+size_t TranspositionTable::megabytes() const { return allocated >> 20; }
+
+// maps the key onto the bucket range with a multiply rather than a modulo,
+// so any table size works
+TTBucket *TranspositionTable::bucketFor(uint64_t key) const {
+    return &buckets[(unsigned __int128)key * bucketCount >> 64];
+}
+
+void TranspositionTable::prefetch(uint64_t key) const {
+    __builtin_prefetch(bucketFor(key));
+}
+
+bool TranspositionTable::probe(uint64_t key, TTData &result) const {
+    const TTBucket *bucket = bucketFor(key);
+
+    for (const TTEntry &entry : bucket->entries) {
+        const uint64_t data = entry.data.load(std::memory_order_relaxed);
+        if ((entry.check.load(std::memory_order_relaxed) ^ data) != key)
+            continue;
+        if (boundOf(data) == NoBound) continue;
+
+        result.move = moveOf(data);
+        result.score = scoreOf(data);
+        result.eval = evalOf(data);
+        result.depth = depthOf(data);
+        result.bound = boundOf(data);
+        return true;
+    }
+
+    return false;
+}
+
+void TranspositionTable::store(uint64_t key, ChessMove move, int score,
+                               int eval, int depth, Bound bound) {
+    TTBucket *bucket = bucketFor(key);
+
+    // reuse this position's entry if present, otherwise evict the entry
+    // with the least depth, counting entries from older searches as
+    // shallower
+    TTEntry *replace = &bucket->entries[0];
+    int worst = 1 << 30;
+    for (TTEntry &entry : bucket->entries) {
+        const uint64_t data = entry.data.load(std::memory_order_relaxed);
+        if ((entry.check.load(std::memory_order_relaxed) ^ data) == key) {
+            // keep a deeper result unless the new one is exact
+            if (bound != ExactBound && depth + 2 < depthOf(data)) return;
+            if (move.isNull()) move = moveOf(data);
+            replace = &entry;
+            break;
+        }
+
+        const int age = (generation - generationOf(data)) & 63;
+        const int value = depthOf(data) - 8 * age;
+        if (value < worst) {
+            worst = value;
+            replace = &entry;
+        }
+    }
+
+    const uint64_t data = pack(move, score, eval, depth, bound, generation);
+    replace->check.store(key ^ data, std::memory_order_relaxed);
+    replace->data.store(data, std::memory_order_relaxed);
+}
+
+int TranspositionTable::hashfull() const {
+    const size_t sample = bucketCount < 250 ? bucketCount : 250;
+    int used = 0, total = 0;
+    for (size_t i = 0; i < sample; i++)
+        for (const TTEntry &entry : buckets[i].entries) {
+            const uint64_t data = entry.data.load(std::memory_order_relaxed);
+            used += boundOf(data) != NoBound &&
+                    generationOf(data) == generation;
+            total++;
+        }
+    return total ? used * 1000 / total : 0;
+}
@@ -0,0 +1,72 @@
+#ifndef TRANSPOSITIONTABLE_H
+#define TRANSPOSITIONTABLE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "ChessMove.h"
+
+enum Bound { NoBound, UpperBound, LowerBound, ExactBound };
+
+// what a probe hands back; score is as stored, relative to the node
+struct TTData {
+    ChessMove move;
+    int score;
+    int eval;
+    int depth;
+    Bound bound;
+};
+
+// 16-byte entry. The key is stored XORed with the data word, so a reader
+// racing a writer sees a key mismatch instead of torn data, and both words
+// are relaxed atomics so concurrent access needs no lock.
+struct TTEntry {
+    std::atomic<uint64_t> check;
+    std::atomic<uint64_t> data;
+};
+
+const int BUCKET_SIZE = 4;
+
+// one cache line of entries sharing an index
+struct alignas(64) TTBucket {
+    TTEntry entries[BUCKET_SIZE];
+};
+
+// transposition table shared by every search thread, sized in megabytes
+// and allocated once
+class TranspositionTable {
+   public:
+    TranspositionTable();
+    TranspositionTable(const TranspositionTable &) = delete;
+    TranspositionTable &operator=(const TranspositionTable &) = delete;
+    ~TranspositionTable();
+
+    // reallocates to the given size in MB and clears; false, keeping the
+    // table there was, if that much memory cannot be had
+    bool resize(size_t megabytes, int threads = 1);
+    // zeroes the table, splitting the work over the given thread count
+    void clear(int threads = 1);
+    // ages existing entries so they are replaced first
+    void newSearch();
+
+    bool probe(uint64_t key, TTData &) const;
+    void store(uint64_t key, ChessMove move, int score, int eval, int depth,
+               Bound bound);
+
+    void prefetch(uint64_t key) const;
+    size_t megabytes() const;
+    // permille of sampled entries written during this search
+    int hashfull() const;
+
+   private:
+    TTBucket *buckets;
+    size_t bucketCount;
+    size_t allocated;
+    uint8_t generation;
+
+    TTBucket *bucketFor(uint64_t key) const;
+    void release();
+};
+
+#endif
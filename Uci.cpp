@@ -0,0 +1,316 @@
+#include "Uci.h"
+
+#include <chrono>
+#include <iostream>
+#include <sstream>
+
+#include "ChessMove.h"
+#include "ChessPiece.h"
+#include "Nnue.h"
+#include "Tablebase.h"
+
+static const char *START_FEN =
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+const int DEFAULT_HASH = 16;
+const int MAX_HASH = 65536;
+const int MAX_THREADS = 256;
+
+Uci::Uci(std::istream &input, std::ostream &output)
+    : in(input),
+      out(output),
+      ownBook(false),
+      bookBest(false) {
+    engine.setOutput(&out, &outputLock);
+    // different openings each session; the generator must not start at 0
+    const auto now = std::chrono::steady_clock::now().time_since_epoch();
+    bookSeed = uint64_t(now.count()) | 1;
+}
+
+Uci::~Uci() {
+    engine.stop();
+    waitForSearch();
+}
+
+void Uci::loop() {
+    std::string line;
+    while (std::getline(in, line))
+        if (!execute(line)) break;
+    engine.stop();
+    waitForSearch();
+}
+
+bool Uci::execute(const std::string &line) {
+    std::istringstream is(line);
+    std::string token;
+    is >> token;
+
+    if (token == "quit") return false;
+
+    if (token == "uci") {
+        identify();
+    } else if (token == "isready") {
+        std::lock_guard<std::mutex> lock(outputLock);
+        out << "readyok" << std::endl;
+    } else if (token == "stop") {
+        engine.stop();
+    } else if (token == "ponderhit") {
+        engine.ponderhit();
+    } else if (token == "ucinewgame") {
+        waitForSearch();
+        engine.clearHash();
+    } else if (token == "setoption") {
+        waitForSearch();
+        setOption(is);
+    } else if (token == "position") {
+        waitForSearch();
+        setPosition(is);
+    } else if (token == "go") {
+        waitForSearch();
+        go(is);
+    } else if (!token.empty()) {
+        std::lock_guard<std::mutex> lock(outputLock);
+        out << "info string unknown command " << token << std::endl;
+    }
+    return true;
+}
+
+void Uci::identify() {
+    std::lock_guard<std::mutex> lock(outputLock);
+    out << "id name Chess-Engine\n"
+        << "id author Albert Ugwudike\n"
+        << "option name Hash type spin default " << DEFAULT_HASH
+        << " min 1 max " << MAX_HASH << '\n'
+        << "option name Threads type spin default 1 min 1 max "
+        << MAX_THREADS << '\n'
+        << "option name Ponder type check default false\n"
+        << "option name Clear Hash type button\n"
+        << "option name EvalFile type string default <empty>\n"
+        << "option name Use NNUE type check default true\n"
+        << "option name Quiescence type check default true\n"
+        << "option name NullMove type check default true\n"
+        << "option name NullMoveReduction type spin default 2 min 1 max 4\n"
+        << "option name LMR type check default true\n"
+        << "option name Futility type check default true\n"
+        << "option name FutilityMargin type spin default 100 min 0 max 1000\n"
+        << "option name Razoring type check default true\n"
+        << "option name RazorMargin type spin default 300 min 0 max 2000\n"
+        << "option name CheckExtensions type check default true\n"
+        << "option name SyzygyPath type string default <empty>\n"
+        << "option name SyzygyProbeLimit type spin default " << TB_PIECES
+        << " min 0 max " << TB_PIECES << "\n"
+        << "option name OwnBook type check default false\n"
+        << "option name BookFile type string default <empty>\n"
+        << "option name BookBestMove type check default false\n"
+        << "uciok" << std::endl;
+}
+
+// "setoption name <id> [value <x>]", where the id may contain spaces
+void Uci::setOption(std::istream &is) {
+    std::string token, name, value;
+    is >> token;
+    while (is >> token && token != "value")
+        name += (name.empty() ? "" : " ") + token;
+    while (is >> token) value += (value.empty() ? "" : " ") + token;
+
+    const int number = atoi(value.c_str());
+    if (name == "Hash") {
+        const int megabytes = std::max(1, std::min(MAX_HASH, number));
+        if (!engine.setHashSize(megabytes)) {
+            std::lock_guard<std::mutex> lock(outputLock);
+            out << "info string cannot allocate " << megabytes
+                << " MB of hash, using " << engine.hashSize() << " MB"
+                << std::endl;
+        }
+    } else if (name == "Threads")
+        engine.setThreads(std::max(1, std::min(MAX_THREADS, number)));
+    else if (name == "Clear Hash")
+        engine.clearHash();
+    else if (name == "EvalFile") {
+        const bool loaded = loadNetwork(value.c_str());
+        // the table's static evals came from the evaluator replaced
+        if (loaded) engine.clearHash();
+        std::lock_guard<std::mutex> lock(outputLock);
+        if (loaded)
+            out << "info string loaded " << value << " using "
+                << nnueKernel() << std::endl;
+        else
+            out << "info string cannot load network " << value << std::endl;
+    } else if (name == "SyzygyPath") {
+        const int found = initTablebases(value == "<empty>" ? "" : value);
+        std::lock_guard<std::mutex> lock(outputLock);
+        out << "info string found " << found << " tablebases" << std::endl;
+    } else if (name == "BookFile") {
+        const bool opened = value != "<empty>" && book.open(value.c_str());
+        if (!opened) book.close();
+        std::lock_guard<std::mutex> lock(outputLock);
+        if (opened)
+            out << "info string loaded book " << value << " with "
+                << book.size() << " entries" << std::endl;
+        else if (value != "<empty>")
+            out << "info string cannot load book " << value << std::endl;
+    } else if (name == "OwnBook")
+        ownBook = value == "true";
+    else if (name == "BookBestMove")
+        bookBest = value == "true";
+    else if (name == "Use NNUE") {
+        if (nnueEnabled() != (value == "true")) engine.clearHash();
+        setNnueEnabled(value == "true");
+    }
+    else if (setSearchOption(name, value, number))
+        return;
+    else if (name != "Ponder") {
+        std::lock_guard<std::mutex> lock(outputLock);
+        out << "info string unknown option " << name << std::endl;
+    }
+}
+
+// the options that switch and tune the selective search
+bool Uci::setSearchOption(const std::string &name, const std::string &value,
+                          int number) {
+    SearchOptions options = engine.options();
+    const bool on = value == "true";
+    if (name == "Quiescence")
+        options.quiescence = on;
+    else if (name == "NullMove")
+        options.nullMove = on;
+    else if (name == "NullMoveReduction")
+        options.nullMoveReduction = std::max(1, std::min(4, number));
+    else if (name == "LMR")
+        options.lateMoveReductions = on;
+    else if (name == "Futility")
+        options.futility = on;
+    else if (name == "FutilityMargin")
+        options.futilityMargin = std::max(0, std::min(1000, number));
+    else if (name == "Razoring")
+        options.razoring = on;
+    else if (name == "RazorMargin")
+        options.razorMargin = std::max(0, std::min(2000, number));
+    else if (name == "CheckExtensions")
+        options.checkExtensions = on;
+    else if (name == "SyzygyProbeLimit")
+        options.probeLimit = std::max(0, std::min(TB_PIECES, number));
+    else
+        return false;
+    engine.setOptions(options);
+    return true;
+}
+
+// "position startpos|fen <fen> [moves <move>...]"
+void Uci::setPosition(std::istream &is) {
+    std::string token, fen;
+    is >> token;
+    if (token == "startpos") {
+        fen = START_FEN;
+        is >> token;
+    } else if (token == "fen") {
+        while (is >> token && token != "moves") fen += token + ' ';
+    } else {
+        return;
+    }
+
+    if (!board.setFen(fen)) {
+        std::lock_guard<std::mutex> lock(outputLock);
+        out << "info string invalid fen " << fen << std::endl;
+        board.setFen(START_FEN);
+        return;
+    }
+
+    // moves arrive in coordinate notation, matched against the legal ones.
+    // A long game outgrows the board's history, which must also hold the
+    // search, so it is set up afresh from where it stands: after a capture
+    // or pawn move once past half the limit, as no repetition reaches back
+    // past those, and at the limit regardless
+    const int limit = MAX_GAME_PLY - MAX_PLY;
+    int plies = 0;
+    char buf[6];
+    while (is >> token) {
+        MoveList moves;
+        board.generateLegalMoves(moves);
+        ChessMove played;
+        for (ChessMove move : moves)
+            if (token == move.str(buf)) played = move;
+
+        if (played.isNull()) {
+            std::lock_guard<std::mutex> lock(outputLock);
+            out << "info string illegal move " << token << std::endl;
+            return;
+        }
+        board.makeMove(played);
+        if (++plies == limit ||
+            (plies >= limit / 2 && board.halfmoves() == 0)) {
+            PackedPosition packed;
+            board.pack(packed);
+            board.unpack(packed);
+            plies = 0;
+        }
+    }
+}
+
+void Uci::go(std::istream &is) {
+    SearchLimits limits;
+    std::string token;
+    while (is >> token) {
+        if (token == "wtime")
+            is >> limits.time[White];
+        else if (token == "btime")
+            is >> limits.time[Black];
+        else if (token == "winc")
+            is >> limits.increment[White];
+        else if (token == "binc")
+            is >> limits.increment[Black];
+        else if (token == "movestogo")
+            is >> limits.movestogo;
+        else if (token == "depth")
+            is >> limits.depth;
+        else if (token == "nodes")
+            is >> limits.nodes;
+        else if (token == "movetime")
+            is >> limits.movetime;
+        else if (token == "infinite")
+            limits.infinite = true;
+        else if (token == "ponder")
+            limits.ponder = true;
+    }
+
+    // "go" with no limits at all searches until told to stop
+    if (!limits.depth && !limits.nodes && !limits.movetime &&
+        !limits.time[White] && !limits.time[Black])
+        limits.infinite = true;
+
+    // a book move is played at once, unless the GUI wants analysis or is
+    // pondering on it
+    if (ownBook && !limits.infinite && !limits.ponder) {
+        const ChessMove move = book.pick(board, bookBest, bookSeed);
+        if (!move.isNull()) {
+            char buf[6];
+            std::lock_guard<std::mutex> lock(outputLock);
+            out << "info string book move\nbestmove " << move.str(buf)
+                << std::endl;
+            return;
+        }
+    }
+
+    searcher = std::thread([this, limits]() {
+        const ChessMove best = engine.search(board, limits);
+        const ChessMove reply = engine.ponderMove();
+
+        char buf[6];
+        std::lock_guard<std::mutex> lock(outputLock);
+        out << "bestmove " << (best.isNull() ? "0000" : best.str(buf));
+        if (!reply.isNull()) out << " ponder " << reply.str(buf);
+        out << std::endl;
+    });
+}
+
+void Uci::waitForSearch() {
+    if (searcher.joinable()) searcher.join();
+}
+
+int uciCommand() {
+    // the GUI reads whole lines; there is no need to keep stdio in step
+    std::ios::sync_with_stdio(false);
+    Uci uci(std::cin, std::cout);
+    uci.loop();
+    return 0;
+}
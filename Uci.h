@@ -0,0 +1,54 @@
+#ifndef UCI_H
+#define UCI_H
+
+#include <iosfwd>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "Book.h"
+#include "ChessBoard.h"
+#include "Engine.h"
+
+// Universal Chess Interface front end. Commands are read on the calling
+// thread while searches run on a thread of their own, so "stop" and
+// "ponderhit" take effect immediately. Output is buffered and only
+// flushed when the GUI is waiting on it.
+class Uci {
+   public:
+    Uci(std::istream &, std::ostream &);
+    ~Uci();
+
+    // handles commands until "quit" or the end of input
+    void loop();
+    // handles one command line; returns false on "quit"
+    bool execute(const std::string &);
+
+   private:
+    std::istream &in;
+    std::ostream &out;
+    std::mutex outputLock;
+
+    ChessBoard board;
+    Engine engine;
+    std::thread searcher;
+
+    // with OwnBook set, "go" answers from the book while it has a move
+    PolyglotBook book;
+    bool ownBook;
+    bool bookBest;
+    uint64_t bookSeed;
+
+    void identify();
+    void setOption(std::istream &);
+    bool setSearchOption(const std::string &name, const std::string &value,
+                         int number);
+    void setPosition(std::istream &);
+    void go(std::istream &);
+    void waitForSearch();
+};
+
+// entry point for "chess uci"
+int uciCommand();
+
+#endif
@@ -0,0 +1,30 @@
+#include "Zobrist.h"
+
+#include "Bitboard.h"
+
+uint64_t pieceKeys[2][6][64];
+uint64_t castlingKeys[16];
+uint64_t epKeys[8];
+uint64_t sideKey;
+
+static bool buildKeys() {
+    uint64_t state = 1070372;
+
+    for (int color = 0; color < 2; color++)
+        for (int type = 0; type < 6; type++)
+            for (int sq = 0; sq < 64; sq++)
+                pieceKeys[color][type][sq] = random64(state);
+
+    for (int rights = 0; rights < 16; rights++)
+        castlingKeys[rights] = random64(state);
+
+    for (int file = 0; file < 8; file++) epKeys[file] = random64(state);
+
+    sideKey = random64(state);
+    return true;
+}
+
+void initZobrist() {
+    static const bool built = buildKeys();
+    (void)built;
+}
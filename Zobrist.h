@@ -0,0 +1,17 @@
+#ifndef ZOBRIST_H
+#define ZOBRIST_H
+
+#include <cstdint>
+
+// random keys whose XOR identifies a position: one per piece on each
+// square, one per combination of castling rights, one per en passant file
+// and one for black to move
+extern uint64_t pieceKeys[2][6][64];
+extern uint64_t castlingKeys[16];
+extern uint64_t epKeys[8];
+extern uint64_t sideKey;
+
+// fills the key tables from a fixed seed, safe to call more than once
+void initZobrist();
+
+#endif